@@ -0,0 +1,176 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <ctime>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <unistd.h>
+#include "../src/config/config.h"
+#include "../src/gesture/recognizer.h"
+#include "../src/io/synthetic_source.h"
+#include "../src/stats/histogram.h"
+
+#define REPLAY_BATCH_SIZE       64
+
+/*
+ * Every binding set, so each recognized gesture counts as a decision
+ */
+static const char* DEFAULT_CONFIG = R"(
+[swipe.commands.three]
+left_up = "true"
+right_up = "true"
+up = "true"
+left_down = "true"
+right_down = "true"
+down = "true"
+left = "true"
+right = "true"
+
+[swipe.commands.four]
+left_up = "true"
+right_up = "true"
+up = "true"
+left_down = "true"
+right_down = "true"
+down = "true"
+left = "true"
+right = "true"
+
+[pinch.commands.two]
+in = "true"
+out = "true"
+rotate_cw = "true"
+rotate_ccw = "true"
+)";
+
+/**
+ * Load the configuration to benchmark with. Without one, the built-in
+ * default is written to a temporary file, as Config only parses files
+ *
+ * @param config_path user supplied gebaard.toml, empty for the default
+ * @return snapshot, nullptr if it can't be loaded
+ */
+static std::shared_ptr<const gebaar::config::Config> load_config(const std::string& config_path)
+{
+    if (!config_path.empty()) {
+        return gebaar::config::Config::parse(config_path);
+    }
+    char scratch[] = "/tmp/gebaar-replay.XXXXXX";
+    int fd = mkstemp(scratch);
+    if (fd < 0) {
+        return nullptr;
+    }
+    close(fd);
+    std::ofstream(scratch) << DEFAULT_CONFIG;
+    auto config = gebaar::config::Config::parse(scratch);
+    unlink(scratch);
+    return config;
+}
+
+static uint64_t now_nsec()
+{
+    struct timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options(argv[0], "Replay a gesture trace through the gesture recognizer");
+
+    std::string config_path;
+    std::string trace_path;
+    int iterations = 100;
+
+    options.add_options()
+            ("c,config", "gebaard.toml to use instead of binding every gesture", cxxopts::value(config_path))
+            ("n,iterations", "Number of times to replay the trace", cxxopts::value(iterations))
+            ("t,trace", "Trace recorded with gebaard --record", cxxopts::value(trace_path))
+            ("h,help", "Prints this help text");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") || trace_path.empty() || iterations < 1) {
+        std::cout << options.help() << std::endl;
+        exit(result.count("help") ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    gebaar::io::TraceReader reader;
+    if (!reader.open(trace_path)) {
+        exit(EXIT_FAILURE);
+    }
+    auto config = load_config(config_path);
+    if (!config) {
+        std::cerr << "Failed to load configuration" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Only bound gestures count as decisions, like in the daemon
+    uint64_t decisions = 0;
+    gebaar::gesture::Recognizer recognizer(config, [&](const gebaar::gesture::recognized_gesture& gesture) {
+        if (!config->bindings.lookup(gesture.type, gesture.fingers, gesture.direction, gesture.modifiers).empty()) {
+            ++decisions;
+        }
+    });
+
+    gebaar::io::SyntheticSource source;
+    gebaar::gesture::gesture_event events[REPLAY_BATCH_SIZE];
+    size_t count;
+
+    // Throughput, without timing individual events
+    uint64_t elapsed = 0;
+    for (int i = 0; i < iterations; ++i) {
+        source.load(reader);
+        uint64_t start = now_nsec();
+        while ((count = source.read_events(events, REPLAY_BATCH_SIZE)) > 0) {
+            for (size_t e = 0; e < count; ++e) {
+                recognizer.handle(events[e]);
+            }
+        }
+        elapsed += now_nsec() - start;
+    }
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    uint64_t timed_decisions = decisions;
+
+    // Cost of every single event, includes the clock overhead
+    gebaar::stats::Histogram event_cost;
+    source.load(reader);
+    while ((count = source.read_events(events, REPLAY_BATCH_SIZE)) > 0) {
+        for (size_t e = 0; e < count; ++e) {
+            uint64_t start = now_nsec();
+            recognizer.handle(events[e]);
+            event_cost.record(now_nsec() - start);
+        }
+    }
+
+    uint64_t total = reader.size() * iterations;
+    std::cout << "events             " << total << std::endl
+              << "decisions          " << timed_decisions << std::endl
+              << "events/s           " << total * 1000000000 / elapsed << std::endl
+              << "decisions/s        " << timed_decisions * 1000000000 / elapsed << std::endl
+              << "mean nsec/event    " << elapsed / (total ? total : 1) << std::endl
+              << std::endl
+              << "event cost (nsec)    count       min       p50       p90       p99       max" << std::endl
+              << "                ";
+    event_cost.print(std::cout);
+    std::cout << std::endl;
+    return 0;
+}
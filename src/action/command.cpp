@@ -0,0 +1,440 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "command.h"
+
+/**
+ * Characters that mean something to the shell outside of quotes
+ */
+static const char* SHELL_SPECIAL = "|&;<>()$`*?[]{}~#!";
+
+/**
+ * Names of the template parameters, indexed by template_parameter
+ */
+static const char* const PARAMETER_NAMES[gebaar::action::PARAM_COUNT] = {"fingers", "dx", "dy", "scale", "angle",
+                                                                          "steps", "device"};
+
+/**
+ * Parse a command line into an argument vector
+ *
+ * @param line command line as written in the configuration file
+ */
+gebaar::action::Command::Command(const std::string& line)
+        :line(line)
+{
+    if (line[0] == '@') {
+        auto split = line.find_first_of(" \t");
+        helper = line.substr(1, split == std::string::npos ? std::string::npos : split - 1);
+        auto start = line.find_first_not_of(" \t", split);
+        if (split != std::string::npos && start != std::string::npos) {
+            payload = line.substr(start);
+        }
+        if ((helper == "key" || helper == "scroll") && !parse_native(helper, payload, native)) {
+            // Left empty, so the binding is ignored instead of looking for
+            // a helper of that name on every trigger
+            std::cerr << "Cannot " << helper << " '" << payload << "'" << std::endl;
+            this->line.clear();
+            helper.clear();
+            payload.clear();
+        }
+    } else if (!line.empty()) {
+        shell = !tokenize();
+        if (shell) {
+            args.clear();
+        }
+    }
+    build_argv();
+    compile_template();
+}
+
+/**
+ * Split the line on whitespace honouring quotes and backslash escapes
+ *
+ * @return false if the line needs a shell to be interpreted correctly
+ */
+bool gebaar::action::Command::tokenize()
+{
+    std::string current;
+    bool in_word = false;
+    char quote = 0;
+
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        size_t length;
+        // Parameters are filled in later, their braces are not the shell's
+        if (c == '{' && parameter_at(line, i, &length) >= 0) {
+            current.append(line, i, length);
+            i += length - 1;
+            in_word = true;
+            continue;
+        }
+        if (quote == '\'') {
+            if (c == '\'') {
+                quote = 0;
+            } else {
+                current += c;
+            }
+        } else if (quote == '"') {
+            if (c == '"') {
+                quote = 0;
+            } else if (c == '$' || c == '`') {
+                return false;
+            } else if (c == '\\' && i + 1 < line.size() && strchr("\"\\$`", line[i + 1])) {
+                current += line[++i];
+            } else {
+                current += c;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_word = true;
+        } else if (c == '\\') {
+            if (i + 1 >= line.size()) {
+                return false;
+            }
+            current += line[++i];
+            in_word = true;
+        } else if (c == ' ' || c == '\t') {
+            if (in_word) {
+                args.push_back(current);
+                current.clear();
+                in_word = false;
+            }
+        } else if (strchr(SHELL_SPECIAL, c) || c == '\n') {
+            return false;
+        } else {
+            // Variable assignments in front of the command, "FOO=bar cmd"
+            if (c == '=' && args.empty()) {
+                return false;
+            }
+            current += c;
+            in_word = true;
+        }
+    }
+    if (quote) {
+        return false;
+    }
+    if (in_word) {
+        args.push_back(current);
+    }
+    return !args.empty();
+}
+
+/**
+ * Template parameter written at a position, like "{scale}"
+ *
+ * @param text text to look at
+ * @param position where the opening brace is
+ * @param length set to the length of the parameter including braces
+ * @return template_parameter or -1 if there is none
+ */
+int gebaar::action::Command::parameter_at(const std::string& text, size_t position, size_t* length)
+{
+    if (text[position] != '{') {
+        return -1;
+    }
+    for (int parameter = 0; parameter < PARAM_COUNT; ++parameter) {
+        size_t name_length = strlen(PARAMETER_NAMES[parameter]);
+        size_t close = position + 1 + name_length;
+        if (close < text.size() && text[close] == '}'
+            && text.compare(position + 1, name_length, PARAMETER_NAMES[parameter]) == 0) {
+            *length = name_length + 2;
+            return parameter;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Split the arguments, the shell line or the payload into segments, if any
+ * of them refers to a parameter
+ */
+void gebaar::action::Command::compile_template()
+{
+    pattern = command_template();
+    if (is_native()) {
+        return;
+    }
+    if (is_helper()) {
+        add_piece(payload);
+    } else if (shell) {
+        add_piece(line);
+    } else {
+        for (const auto& arg : args) {
+            add_piece(arg);
+        }
+    }
+    if (pattern.parameters == 0) {
+        pattern = command_template();
+    }
+}
+
+/**
+ * Add the segments of one argument. For shell lines the quotes around
+ * every parameter are tracked, so its value is escaped to match
+ *
+ * @param text argument
+ */
+void gebaar::action::Command::add_piece(const std::string& text)
+{
+    bool track = shell && !is_helper();
+    char quote = 0;
+    size_t literal = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        size_t length;
+        int parameter = parameter_at(text, i, &length);
+        if (parameter < 0) {
+            if (!track) {
+                continue;
+            }
+            if (text[i] == '\\' && quote != '\'') {
+                ++i;
+            } else if ((text[i] == '\'' || text[i] == '"') && (quote == 0 || quote == text[i])) {
+                quote = quote == 0 ? text[i] : 0;
+            }
+            continue;
+        }
+        if (i > literal) {
+            pattern.segments.push_back({-1, static_cast<uint32_t>(pattern.literals.size()),
+                                        static_cast<uint32_t>(i - literal), 0});
+            pattern.literals.append(text, literal, i - literal);
+        }
+        pattern.segments.push_back({parameter, 0, 0, quote});
+        pattern.parameters |= 1u << parameter;
+        i += length - 1;
+        literal = i + 1;
+    }
+    if (literal < text.size()) {
+        pattern.segments.push_back({-1, static_cast<uint32_t>(pattern.literals.size()),
+                                    static_cast<uint32_t>(text.size() - literal), 0});
+        pattern.literals.append(text, literal, std::string::npos);
+    }
+    pattern.pieces.push_back(static_cast<uint32_t>(pattern.segments.size()));
+}
+
+/**
+ * Fill in a template. Only copies and formats into the buffer, so a
+ * templated command runs without allocating. Shell lines get the device
+ * name quoted, or escaped for the quotes it already sits in, the numbers
+ * need no quoting
+ *
+ * @param values parameters of the gesture
+ * @param buffer buffer to fill, argv is null-terminated and ready to
+ * execute, for helpers text holds the payload
+ * @return false if the command does not fit the buffer
+ */
+bool gebaar::action::Command::fill(const template_values& values, command_buffer& buffer) const
+{
+    bool quote = shell && !is_helper();
+    size_t used = 0;
+    size_t argc = 0;
+    size_t next = 0;
+    for (uint32_t end : pattern.pieces) {
+        size_t start = used;
+        for (; next < end; ++next) {
+            const segment& part = pattern.segments[next];
+            size_t written = part.length;
+            if (part.parameter >= 0) {
+                if (!format_value(values, part.parameter, quote, part.quote, buffer.text + used,
+                                  COMMAND_BUFFER_SIZE - used, &written)) {
+                    return false;
+                }
+            } else if (part.length < COMMAND_BUFFER_SIZE - used) {
+                memcpy(buffer.text + used, pattern.literals.data() + part.offset, part.length);
+            } else {
+                return false;
+            }
+            used += written;
+        }
+        if (used >= COMMAND_BUFFER_SIZE || argc >= COMMAND_MAX_ARGS) {
+            return false;
+        }
+        buffer.text[used++] = '\0';
+        buffer.length = used - 1 - start;
+        buffer.argv[argc++] = buffer.text + start;
+    }
+    if (quote) {
+        buffer.argv[2] = buffer.argv[0];
+        buffer.argv[0] = const_cast<char*>("/bin/sh");
+        buffer.argv[1] = const_cast<char*>("-c");
+        argc = 3;
+    }
+    buffer.argv[argc] = nullptr;
+    return true;
+}
+
+/**
+ * Format one parameter
+ *
+ * @param values parameters of the gesture
+ * @param parameter template_parameter to format
+ * @param shell escape text for the shell
+ * @param quote shell quote the parameter sits in, 0 outside of quotes
+ * @param out where to write, not terminated
+ * @param size room left at out
+ * @param written set to the number of characters written
+ * @return false if there is not enough room
+ */
+bool gebaar::action::Command::format_value(const template_values& values, int parameter, bool shell, char quote,
+                                           char* out, size_t size, size_t* written)
+{
+    int length = 0;
+    switch (parameter) {
+        case PARAM_FINGERS:
+            length = snprintf(out, size, "%d", values.fingers);
+            break;
+        case PARAM_DX:
+            length = snprintf(out, size, "%g", values.dx);
+            break;
+        case PARAM_DY:
+            length = snprintf(out, size, "%g", values.dy);
+            break;
+        case PARAM_SCALE:
+            length = snprintf(out, size, "%g", values.scale);
+            break;
+        case PARAM_ANGLE:
+            length = snprintf(out, size, "%g", values.angle);
+            break;
+        case PARAM_STEPS:
+            length = snprintf(out, size, "%u", values.steps);
+            break;
+        default: {
+            const char* device = values.device != nullptr ? values.device : "";
+            if (!shell) {
+                length = snprintf(out, size, "%s", device);
+                break;
+            }
+            // Outside quotes the name gets its own, 'name'. In single quotes
+            // a quote becomes '\'', in double quotes \ " $ and ` are escaped
+            size_t pos = 0;
+            if (quote == 0) {
+                if (size < 2) {
+                    return false;
+                }
+                out[pos++] = '\'';
+            }
+            for (const char* c = device; *c != '\0'; ++c) {
+                if (pos + 5 >= size) {
+                    return false;
+                }
+                if (*c == '\'' && quote != '"') {
+                    memcpy(out + pos, "'\\''", 4);
+                    pos += 4;
+                } else {
+                    if (quote == '"' && strchr("\\\"$`", *c) != nullptr) {
+                        out[pos++] = '\\';
+                    }
+                    out[pos++] = *c;
+                }
+            }
+            if (quote == 0) {
+                out[pos++] = '\'';
+            }
+            length = static_cast<int>(pos);
+        }
+    }
+    // snprintf terminates, which needs one more byte than the text
+    if (length < 0 || static_cast<size_t>(length) >= size) {
+        return false;
+    }
+    *written = static_cast<size_t>(length);
+    return true;
+}
+
+/**
+ * Point the null-terminated argv at the stored arguments
+ */
+void gebaar::action::Command::build_argv()
+{
+    argv.clear();
+    argv.reserve(args.size() + 1);
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+}
+
+/**
+ * Copy of the command with one more argument, added to the payload for
+ * helpers. Meant for runs that are rate limited anyway, it allocates
+ *
+ * @param arg argument to append, must not need quoting
+ * @return command with the argument
+ */
+gebaar::action::Command gebaar::action::Command::with_argument(const std::string& arg) const
+{
+    Command extended(*this);
+    extended.line += " " + arg;
+    if (is_helper()) {
+        extended.payload += extended.payload.empty() ? arg : " " + arg;
+    } else if (!shell) {
+        extended.args.push_back(arg);
+        extended.build_argv();
+    }
+    extended.compile_template();
+    return extended;
+}
+
+gebaar::action::Command::Command(const Command& other)
+        :line(other.line), shell(other.shell), helper(other.helper), payload(other.payload), args(other.args),
+         policy(other.policy), pattern(other.pattern), native(other.native)
+{
+    build_argv();
+}
+
+gebaar::action::Command::Command(Command&& other) noexcept
+        :line(std::move(other.line)), shell(other.shell), helper(std::move(other.helper)),
+         payload(std::move(other.payload)), args(std::move(other.args)), policy(other.policy),
+         pattern(std::move(other.pattern)), native(other.native)
+{
+    build_argv();
+}
+
+gebaar::action::Command& gebaar::action::Command::operator=(const Command& other)
+{
+    if (this != &other) {
+        line = other.line;
+        shell = other.shell;
+        helper = other.helper;
+        payload = other.payload;
+        args = other.args;
+        policy = other.policy;
+        pattern = other.pattern;
+        native = other.native;
+        build_argv();
+    }
+    return *this;
+}
+
+gebaar::action::Command& gebaar::action::Command::operator=(Command&& other) noexcept
+{
+    if (this != &other) {
+        line = std::move(other.line);
+        shell = other.shell;
+        helper = std::move(other.helper);
+        payload = std::move(other.payload);
+        args = std::move(other.args);
+        policy = other.policy;
+        pattern = std::move(other.pattern);
+        native = other.native;
+        build_argv();
+    }
+    return *this;
+}
@@ -0,0 +1,167 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_COMMAND_H
+#define GEBAAR_COMMAND_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "native.h"
+
+#define COMMAND_BUFFER_SIZE     4096
+#define COMMAND_MAX_ARGS        64
+
+namespace gebaar::action {
+    /**
+     * Gesture parameters a command line can refer to as {fingers}, {dx},
+     * {dy}, {scale}, {angle}, {steps} and {device}
+     */
+    enum template_parameter {
+        PARAM_FINGERS, PARAM_DX, PARAM_DY, PARAM_SCALE, PARAM_ANGLE, PARAM_STEPS, PARAM_DEVICE, PARAM_COUNT
+    };
+
+    struct template_values {
+        int fingers;
+        double dx;              // mm
+        double dy;
+        double scale;
+        double angle;           // degrees
+        unsigned int steps;
+        const char* device;     // must stay valid while a run is held back
+    };
+
+    /**
+     * Where a templated command is filled in, reused for every run
+     */
+    struct command_buffer {
+        char text[COMMAND_BUFFER_SIZE];
+        char* argv[COMMAND_MAX_ARGS + 1];
+        size_t length;          // of the last piece, the payload of helpers
+    };
+
+    /**
+     * How often a binding may run. Everything 0 is no limit at all
+     */
+    struct rate_policy {
+        uint64_t debounce_usec;     // run once triggers paused this long
+        uint64_t min_interval_usec; // between two runs
+        double rate;                // runs per second, token bucket
+        double burst;               // token bucket size
+        bool collapse;              // run held back steps later, as one run with the count appended
+
+        bool limited() const { return debounce_usec > 0 || min_interval_usec > 0 || rate > 0; }
+    };
+
+    /**
+     * A bound command line, tokenized once at config load. Commands that need
+     * the shell (pipes, redirects, variables, globs...) keep only their line
+     * and are run through /bin/sh -c, everything else is executed directly.
+     * Lines of the form "@helper payload" are not executed at all but sent to
+     * the named persistent helper, "@key" and "@scroll" lines are native
+     * actions injected through uinput.
+     *
+     * Gesture parameters in braces make the command a template: the
+     * arguments, shell line or payload are split into literal and parameter
+     * segments up front, and fill() only copies and formats them.
+     */
+    class Command {
+    public:
+        Command() = default;
+
+        explicit Command(const std::string& line);
+
+        Command(const Command& other);
+
+        Command(Command&& other) noexcept;
+
+        Command& operator=(const Command& other);
+
+        Command& operator=(Command&& other) noexcept;
+
+        bool empty() const { return line.empty(); }
+
+        bool use_shell() const { return shell; }
+
+        bool is_helper() const { return !helper.empty() && native.kind == NATIVE_NONE; }
+
+        bool is_native() const { return native.kind != NATIVE_NONE; }
+
+        const native_action& get_native() const { return native; }
+
+        const std::string& get_helper() const { return helper; }
+
+        const std::string& get_payload() const { return payload; }
+
+        const std::string& get_line() const { return line; }
+
+        char* const* get_argv() const { return argv.data(); }
+
+        const rate_policy& get_policy() const { return policy; }
+
+        void set_policy(const rate_policy& limits) { policy = limits; }
+
+        Command with_argument(const std::string& arg) const;
+
+        bool is_template() const { return !pattern.segments.empty(); }
+
+        bool uses(template_parameter parameter) const { return pattern.parameters & (1u << parameter); }
+
+        bool fill(const template_values& values, command_buffer& buffer) const;
+
+    private:
+        struct segment {
+            int parameter;          // template_parameter, -1 for literal text
+            uint32_t offset;        // into literals
+            uint32_t length;
+            char quote;             // shell quote a parameter sits in, 0 outside
+        };
+
+        struct command_template {
+            std::string literals;
+            std::vector<segment> segments;
+            std::vector<uint32_t> pieces;   // end of every argument in segments
+            unsigned int parameters = 0;    // mask of the ones used
+        };
+
+        std::string line;
+        bool shell = false;
+        std::string helper;
+        std::string payload;
+        std::vector<std::string> args;
+        std::vector<char*> argv;
+        rate_policy policy{};
+        command_template pattern;
+        native_action native{};
+
+        bool tokenize();
+
+        void compile_template();
+
+        void add_piece(const std::string& text);
+
+        static int parameter_at(const std::string& text, size_t position, size_t* length);
+
+        static bool format_value(const template_values& values, int parameter, bool shell, char quote, char* out,
+                                 size_t size, size_t* written);
+
+        void build_argv();
+    };
+}
+
+#endif //GEBAAR_COMMAND_H
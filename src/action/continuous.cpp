@@ -0,0 +1,123 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <linux/input-event-codes.h>
+#include "continuous.h"
+
+gebaar::action::ContinuousOutput::ContinuousOutput(VirtualInput& output)
+        :output(output)
+{
+}
+
+/**
+ * Add scroll movement
+ *
+ * @param dx high resolution units to the right
+ * @param dy high resolution units up
+ */
+void gebaar::action::ContinuousOutput::scroll(double dx, double dy)
+{
+    scroll_x.units += dx;
+    scroll_y.units += dy;
+}
+
+/**
+ * Add zoom
+ *
+ * @param amount high resolution units, positive zooms in
+ */
+void gebaar::action::ContinuousOutput::zoom(double amount)
+{
+    zoom_axis.units += amount;
+}
+
+/**
+ * Forget everything not sent yet, when a gesture starts
+ */
+void gebaar::action::ContinuousOutput::reset()
+{
+    scroll_x = {};
+    scroll_y = {};
+    zoom_axis = {};
+}
+
+/**
+ * Check whether a flush would send anything
+ *
+ * @return bool
+ */
+bool gebaar::action::ContinuousOutput::pending() const
+{
+    return std::abs(scroll_x.units) >= 1 || std::abs(scroll_y.units) >= 1 || std::abs(zoom_axis.units) >= 1;
+}
+
+/**
+ * Send the whole units that added up. Zoom is ctrl and the wheel, which is
+ * what browsers and image viewers zoom on, or the zoom keys once per click
+ *
+ * @param zoom_keys zoom with KEY_ZOOMIN and KEY_ZOOMOUT
+ */
+void gebaar::action::ContinuousOutput::flush(bool zoom_keys)
+{
+    int units_x = take_units(scroll_x);
+    int units_y = take_units(scroll_y);
+    if (units_x != 0 || units_y != 0) {
+        output.send_wheel(units_x, units_y, take_clicks(scroll_x, units_x), take_clicks(scroll_y, units_y), 0);
+    }
+
+    int zoom_units = take_units(zoom_axis);
+    int zoom_clicks = take_clicks(zoom_axis, zoom_units);
+    if (!zoom_keys && zoom_units != 0) {
+        output.send_wheel(0, zoom_units, 0, zoom_clicks, KEY_LEFTCTRL);
+    } else if (zoom_keys && zoom_clicks != 0) {
+        native_action keys{};
+        keys.kind = NATIVE_KEY;
+        keys.keys[0] = zoom_clicks > 0 ? KEY_ZOOMIN : KEY_ZOOMOUT;
+        keys.key_count = 1;
+        output.send(keys, static_cast<unsigned int>(std::abs(zoom_clicks)));
+    }
+}
+
+/**
+ * Take the whole units of an axis, leaving the fraction for later
+ *
+ * @param axis wheel axis
+ * @return units to send
+ */
+int gebaar::action::ContinuousOutput::take_units(wheel_axis& axis)
+{
+    int units = static_cast<int>(axis.units);
+    axis.units -= units;
+    return units;
+}
+
+/**
+ * Legacy wheel clicks due after sending some units
+ *
+ * @param axis wheel axis
+ * @param units units about to be sent
+ * @return clicks to send along
+ */
+int gebaar::action::ContinuousOutput::take_clicks(wheel_axis& axis, int units)
+{
+    axis.clicks += units;
+    int clicks = axis.clicks / WHEEL_HI_RES_PER_CLICK;
+    axis.clicks -= clicks * WHEEL_HI_RES_PER_CLICK;
+    return clicks;
+}
@@ -0,0 +1,66 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_CONTINUOUS_H
+#define GEBAAR_CONTINUOUS_H
+
+#include "uinput.h"
+
+#define WHEEL_HI_RES_PER_CLICK  120
+
+namespace gebaar::action {
+    /**
+     * Turns continuous gestures into smooth wheel output. Movement adds up
+     * in fractions of high resolution wheel units and is written out by
+     * flush() at a fixed rate, whatever the touchpad's event rate, with the
+     * fraction that doesn't make a whole unit yet carried over. Legacy
+     * wheel clicks are sent every WHEEL_HI_RES_PER_CLICK units, like a
+     * real high resolution wheel does.
+     */
+    class ContinuousOutput {
+    public:
+        explicit ContinuousOutput(VirtualInput& output);
+
+        void scroll(double dx, double dy);
+
+        void zoom(double amount);
+
+        void reset();
+
+        bool pending() const;
+
+        void flush(bool zoom_keys);
+
+    private:
+        struct wheel_axis {
+            double units;       // high resolution units not sent yet
+            int clicks;         // units sent since the last legacy click
+        };
+
+        VirtualInput& output;
+        wheel_axis scroll_x{};
+        wheel_axis scroll_y{};
+        wheel_axis zoom_axis{};
+
+        static int take_units(wheel_axis& axis);
+
+        static int take_clicks(wheel_axis& axis, int units);
+    };
+}
+
+#endif //GEBAAR_CONTINUOUS_H
@@ -0,0 +1,176 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <csignal>
+#include <iostream>
+#include <sys/wait.h>
+#include "executor.h"
+
+extern char** environ;
+
+/**
+ * Take SIGCHLD back from the daemonizer. Finished children are reaped from
+ * the main loop, which watches SIGCHLD and calls reap()
+ *
+ * @return bool
+ */
+bool gebaar::action::Executor::initialize()
+{
+    // The daemonizer ignores SIGCHLD, which makes the kernel reap children
+    // for us and leaves nothing to count in-flight commands with
+    return signal(SIGCHLD, SIG_DFL) != SIG_ERR;
+}
+
+/**
+ * Launch a command without waiting for it to finish, counting it against
+ * the in-flight limit of its gesture
+ *
+ * @param command command to run
+ * @param group gesture the command belongs to
+ * @param max_in_flight maximum running commands for the group, 0 for no limit
+ * @return bool that denotes whether the command was started
+ */
+bool gebaar::action::Executor::spawn(const Command& command, int group, unsigned int max_in_flight)
+{
+    if (command.empty()) {
+        return false;
+    }
+    if (max_in_flight > 0 && in_flight[group] >= max_in_flight) {
+        return false;
+    }
+
+    pid_t pid = launch(command, nullptr);
+    if (pid < 0) {
+        return false;
+    }
+    children[pid] = group;
+    ++in_flight[group];
+    return true;
+}
+
+/**
+ * Launch a filled in command template, see spawn(const Command&, ...)
+ *
+ * @param argv null-terminated arguments, the program first
+ * @param group gesture the command belongs to
+ * @param max_in_flight maximum running commands for the group, 0 for no limit
+ * @return bool that denotes whether the command was started
+ */
+bool gebaar::action::Executor::spawn(char* const* argv, int group, unsigned int max_in_flight)
+{
+    if (max_in_flight > 0 && in_flight[group] >= max_in_flight) {
+        return false;
+    }
+
+    pid_t pid = launch(argv, nullptr);
+    if (pid < 0) {
+        std::cerr << "Failed to run '" << argv[0] << "'" << std::endl;
+        return false;
+    }
+    children[pid] = group;
+    ++in_flight[group];
+    return true;
+}
+
+/**
+ * Start a child process. Commands that were tokenized at load time are
+ * executed directly, the rest through the shell
+ *
+ * @param command command to run
+ * @param file_actions descriptor setup for the child, may be nullptr
+ * @return process id of the child or -1 on failure
+ */
+pid_t gebaar::action::Executor::launch(const Command& command, const posix_spawn_file_actions_t* file_actions)
+{
+    pid_t pid;
+    if (command.use_shell()) {
+        char* argv[] = {const_cast<char*>("/bin/sh"), const_cast<char*>("-c"),
+                        const_cast<char*>(command.get_line().c_str()), nullptr};
+        pid = launch(argv, file_actions);
+    } else {
+        pid = launch(command.get_argv(), file_actions);
+    }
+    if (pid < 0) {
+        std::cerr << "Failed to run '" << command.get_line() << "'" << std::endl;
+    }
+    return pid;
+}
+
+/**
+ * Start a child process from an argument vector, the program is looked up
+ * in PATH unless it contains a slash
+ *
+ * @param argv null-terminated arguments, the program first
+ * @param file_actions descriptor setup for the child, may be nullptr
+ * @return process id of the child or -1 on failure
+ */
+pid_t gebaar::action::Executor::launch(char* const* argv, const posix_spawn_file_actions_t* file_actions)
+{
+    // Children must not inherit our blocked SIGCHLD
+    sigset_t empty_mask;
+    sigemptyset(&empty_mask);
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGCHLD);
+    sigaddset(&default_signals, SIGPIPE);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setsigmask(&attr, &empty_mask);
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], file_actions, &attr, argv, environ);
+    posix_spawnattr_destroy(&attr);
+    return err == 0 ? pid : -1;
+}
+
+/**
+ * Collect every child that exited since the last call, called on SIGCHLD.
+ * SIGCHLD does not queue, so one delivery may stand for several children
+ */
+void gebaar::action::Executor::reap()
+{
+    pid_t pid;
+    while ((pid = waitpid(-1, nullptr, WNOHANG)) > 0) {
+        release(pid);
+    }
+}
+
+/**
+ * Forget about a finished child and free its in-flight slot
+ *
+ * @param pid process id of the finished child
+ */
+void gebaar::action::Executor::release(pid_t pid)
+{
+    auto child = children.find(pid);
+    if (child == children.end()) {
+        return;
+    }
+    auto count = in_flight.find(child->second);
+    if (count != in_flight.end() && count->second > 0) {
+        --count->second;
+    }
+    children.erase(child);
+}
+
+gebaar::action::Executor::Executor() = default;
+
+gebaar::action::Executor::~Executor() = default;
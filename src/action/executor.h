@@ -0,0 +1,54 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_EXECUTOR_H
+#define GEBAAR_EXECUTOR_H
+
+#include <spawn.h>
+#include <unordered_map>
+#include <sys/types.h>
+#include "command.h"
+
+namespace gebaar::action {
+    class Executor {
+    public:
+        Executor();
+
+        ~Executor();
+
+        bool initialize();
+
+        bool spawn(const Command& command, int group, unsigned int max_in_flight);
+
+        bool spawn(char* const* argv, int group, unsigned int max_in_flight);
+
+        pid_t launch(const Command& command, const posix_spawn_file_actions_t* file_actions);
+
+        pid_t launch(char* const* argv, const posix_spawn_file_actions_t* file_actions);
+
+        void reap();
+
+    private:
+        std::unordered_map<pid_t, int> children;
+        std::unordered_map<int, unsigned int> in_flight;
+
+        void release(pid_t pid);
+    };
+}
+
+#endif //GEBAAR_EXECUTOR_H
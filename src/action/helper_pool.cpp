@@ -0,0 +1,237 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "helper_pool.h"
+#include "../util.h"
+
+#define IPC_MAGIC           "i3-ipc"
+#define IPC_RUN_COMMAND     0
+
+/**
+ * Helper pool constructor, helper processes are started through the executor
+ *
+ * @param executor executor used to launch helper processes
+ */
+gebaar::action::HelperPool::HelperPool(Executor& executor)
+        :executor(executor)
+{
+    // A helper that went away must not take the daemon with it
+    signal(SIGPIPE, SIG_IGN);
+}
+
+gebaar::action::HelperPool::~HelperPool()
+{
+    for (auto& entry : helpers) {
+        disconnect_helper(entry.second);
+    }
+}
+
+/**
+ * Replace the configured process helpers. Helpers are started lazily on
+ * their first message
+ *
+ * @param commands helper name to command map from the configuration
+ */
+void gebaar::action::HelperPool::set_helpers(const std::map<std::string, Command>& commands)
+{
+    for (auto& entry : helpers) {
+        disconnect_helper(entry.second);
+    }
+    helpers.clear();
+
+    for (const auto& entry : commands) {
+        if (entry.second.empty() || entry.second.is_helper()) {
+            std::cerr << "Ignoring invalid helper '" << entry.first << "'" << std::endl;
+            continue;
+        }
+        helper process{};
+        process.type = HELPER_PROCESS;
+        process.command = entry.second;
+        helpers.emplace(entry.first, process);
+    }
+}
+
+/**
+ * Deliver an "@helper payload" command to its helper
+ *
+ * @param command helper command
+ * @return bool that denotes whether the message was written
+ */
+bool gebaar::action::HelperPool::send(const Command& command)
+{
+    return send(command, command.get_payload().data(), command.get_payload().size());
+}
+
+/**
+ * Deliver a helper command with a filled in payload
+ *
+ * @param command helper command
+ * @param payload payload to send instead of the command's own
+ * @param length payload length
+ * @return bool that denotes whether the message was written
+ */
+bool gebaar::action::HelperPool::send(const Command& command, const char* payload, size_t length)
+{
+    helper* target = find_helper(command.get_helper());
+    if (target == nullptr) {
+        std::cerr << "Unknown helper '" << command.get_helper() << "'" << std::endl;
+        return false;
+    }
+    if (target->fd < 0 && !connect_helper(*target)) {
+        return false;
+    }
+    if (write_message(*target, payload, length)) {
+        return true;
+    }
+
+    // The helper died or closed the connection, try once more with a fresh one
+    disconnect_helper(*target);
+    return connect_helper(*target) && write_message(*target, payload, length);
+}
+
+/**
+ * Look up a configured helper, falling back to the built-in IPC helpers
+ *
+ * @param name helper name
+ * @return helper or nullptr if there is no such helper
+ */
+gebaar::action::HelperPool::helper* gebaar::action::HelperPool::find_helper(const std::string& name)
+{
+    auto found = helpers.find(name);
+    if (found != helpers.end()) {
+        return &found->second;
+    }
+
+    std::string socket_path;
+    if (name == "sway") {
+        socket_path = gebaar::util::stringFromCharArray(getenv("SWAYSOCK"));
+    } else if (name == "i3") {
+        socket_path = gebaar::util::stringFromCharArray(getenv("I3SOCK"));
+    }
+    if (socket_path.empty()) {
+        return nullptr;
+    }
+    helper ipc{};
+    ipc.type = HELPER_IPC;
+    ipc.socket_path = socket_path;
+    return &helpers.emplace(name, ipc).first->second;
+}
+
+/**
+ * Start a helper process with a pipe on its stdin, or connect to an IPC socket
+ *
+ * @param target helper to connect
+ * @return bool
+ */
+bool gebaar::action::HelperPool::connect_helper(helper& target)
+{
+    if (target.type == HELPER_IPC) {
+        struct sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, target.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        target.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (target.fd < 0 || connect(target.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            std::cerr << "Failed to connect to " << target.socket_path << std::endl;
+            disconnect_helper(target);
+            return false;
+        }
+        return true;
+    }
+
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) < 0) {
+        return false;
+    }
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_adddup2(&file_actions, pipe_fds[0], STDIN_FILENO);
+    target.pid = executor.launch(target.command, &file_actions);
+    posix_spawn_file_actions_destroy(&file_actions);
+    close(pipe_fds[0]);
+
+    if (target.pid < 0) {
+        close(pipe_fds[1]);
+        return false;
+    }
+    fcntl(pipe_fds[1], F_SETFL, fcntl(pipe_fds[1], F_GETFL) | O_NONBLOCK);
+    target.fd = pipe_fds[1];
+    return true;
+}
+
+/**
+ * Close the connection to a helper. Helper processes exit on end of input
+ * and are reaped by the executor like any other child
+ *
+ * @param target helper to disconnect
+ */
+void gebaar::action::HelperPool::disconnect_helper(helper& target)
+{
+    if (target.fd >= 0) {
+        close(target.fd);
+    }
+    target.fd = -1;
+    target.pid = -1;
+}
+
+/**
+ * Write one message without blocking. If the helper cannot keep up the
+ * message is dropped rather than stalling the event loop
+ *
+ * @param target connected helper
+ * @param payload action payload
+ * @param length payload length
+ * @return bool false if the connection is broken
+ */
+bool gebaar::action::HelperPool::write_message(helper& target, const char* payload, size_t length)
+{
+    // Header, payload and newline go out in one write, without copying
+    char newline = '\n';
+    char header[sizeof(IPC_MAGIC) - 1 + 2 * sizeof(uint32_t)];
+    struct iovec parts[2] = {{nullptr, 0}, {const_cast<char*>(payload), length}};
+    if (target.type == HELPER_IPC) {
+        // Replies are of no interest, but must not pile up in the socket
+        char discard[512];
+        while (read(target.fd, discard, sizeof(discard)) > 0) {
+        }
+
+        uint32_t fields[2] = {static_cast<uint32_t>(length), IPC_RUN_COMMAND};
+        memcpy(header, IPC_MAGIC, sizeof(IPC_MAGIC) - 1);
+        memcpy(header + sizeof(IPC_MAGIC) - 1, fields, sizeof(fields));
+        parts[0] = {header, sizeof(header)};
+    } else {
+        parts[0] = {const_cast<char*>(payload), length};
+        parts[1] = {&newline, 1};
+    }
+
+    ssize_t written = writev(target.fd, parts, 2);
+    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        std::cerr << "Helper is busy, dropping action '" << std::string(payload, length) << "'" << std::endl;
+        return true;
+    }
+    return written == static_cast<ssize_t>(parts[0].iov_len + parts[1].iov_len);
+}
@@ -0,0 +1,72 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_HELPER_POOL_H
+#define GEBAAR_HELPER_POOL_H
+
+#include <map>
+#include <string>
+#include "command.h"
+#include "executor.h"
+
+namespace gebaar::action {
+    /**
+     * Long-lived processes and IPC connections that receive actions as
+     * messages, so a repeated action costs a write() instead of a fork+exec.
+     *
+     * Process helpers get one line per action on their stdin. The built-in
+     * "sway" and "i3" helpers send the payload as a RUN_COMMAND message over
+     * the window manager's IPC socket.
+     */
+    class HelperPool {
+    public:
+        explicit HelperPool(Executor& executor);
+
+        ~HelperPool();
+
+        void set_helpers(const std::map<std::string, Command>& commands);
+
+        bool send(const Command& command);
+
+        bool send(const Command& command, const char* payload, size_t length);
+
+    private:
+        enum helper_type {HELPER_PROCESS, HELPER_IPC};
+
+        struct helper {
+            helper_type type;
+            Command command;
+            std::string socket_path;
+            int fd = -1;
+            pid_t pid = -1;
+        };
+
+        Executor& executor;
+        std::map<std::string, helper> helpers;
+
+        helper* find_helper(const std::string& name);
+
+        bool connect_helper(helper& target);
+
+        void disconnect_helper(helper& target);
+
+        bool write_message(helper& target, const char* payload, size_t length);
+    };
+}
+
+#endif //GEBAAR_HELPER_POOL_H
@@ -0,0 +1,146 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <linux/input-event-codes.h>
+#include <sstream>
+#include "native.h"
+
+/**
+ * Key names understood in "@key" actions, matched case insensitively
+ */
+static const struct {
+    const char* name;
+    uint16_t code;
+} KEY_NAMES[] = {
+        {"ctrl", KEY_LEFTCTRL}, {"control", KEY_LEFTCTRL}, {"shift", KEY_LEFTSHIFT}, {"alt", KEY_LEFTALT},
+        {"altgr", KEY_RIGHTALT}, {"super", KEY_LEFTMETA}, {"meta", KEY_LEFTMETA}, {"logo", KEY_LEFTMETA},
+        {"a", KEY_A}, {"b", KEY_B}, {"c", KEY_C}, {"d", KEY_D}, {"e", KEY_E}, {"f", KEY_F}, {"g", KEY_G},
+        {"h", KEY_H}, {"i", KEY_I}, {"j", KEY_J}, {"k", KEY_K}, {"l", KEY_L}, {"m", KEY_M}, {"n", KEY_N},
+        {"o", KEY_O}, {"p", KEY_P}, {"q", KEY_Q}, {"r", KEY_R}, {"s", KEY_S}, {"t", KEY_T}, {"u", KEY_U},
+        {"v", KEY_V}, {"w", KEY_W}, {"x", KEY_X}, {"y", KEY_Y}, {"z", KEY_Z},
+        {"0", KEY_0}, {"1", KEY_1}, {"2", KEY_2}, {"3", KEY_3}, {"4", KEY_4}, {"5", KEY_5}, {"6", KEY_6},
+        {"7", KEY_7}, {"8", KEY_8}, {"9", KEY_9},
+        {"f1", KEY_F1}, {"f2", KEY_F2}, {"f3", KEY_F3}, {"f4", KEY_F4}, {"f5", KEY_F5}, {"f6", KEY_F6},
+        {"f7", KEY_F7}, {"f8", KEY_F8}, {"f9", KEY_F9}, {"f10", KEY_F10}, {"f11", KEY_F11}, {"f12", KEY_F12},
+        {"left", KEY_LEFT}, {"right", KEY_RIGHT}, {"up", KEY_UP}, {"down", KEY_DOWN},
+        {"home", KEY_HOME}, {"end", KEY_END}, {"pageup", KEY_PAGEUP}, {"pagedown", KEY_PAGEDOWN},
+        {"insert", KEY_INSERT}, {"delete", KEY_DELETE}, {"backspace", KEY_BACKSPACE},
+        {"enter", KEY_ENTER}, {"return", KEY_ENTER}, {"esc", KEY_ESC}, {"escape", KEY_ESC}, {"tab", KEY_TAB},
+        {"space", KEY_SPACE}, {"minus", KEY_MINUS}, {"equal", KEY_EQUAL}, {"comma", KEY_COMMA}, {"period", KEY_DOT},
+        {"slash", KEY_SLASH}, {"backslash", KEY_BACKSLASH}, {"semicolon", KEY_SEMICOLON},
+        {"apostrophe", KEY_APOSTROPHE}, {"grave", KEY_GRAVE}, {"bracketleft", KEY_LEFTBRACE},
+        {"bracketright", KEY_RIGHTBRACE}, {"print", KEY_SYSRQ},
+        {"volumeup", KEY_VOLUMEUP}, {"volumedown", KEY_VOLUMEDOWN}, {"mute", KEY_MUTE},
+        {"brightnessup", KEY_BRIGHTNESSUP}, {"brightnessdown", KEY_BRIGHTNESSDOWN},
+        {"playpause", KEY_PLAYPAUSE}, {"next", KEY_NEXTSONG}, {"previous", KEY_PREVIOUSSONG},
+        {"zoomin", KEY_ZOOMIN}, {"zoomout", KEY_ZOOMOUT},
+};
+
+/**
+ * Key code of a key name
+ *
+ * @param name key name
+ * @return key code, 0 if unknown
+ */
+static uint16_t key_code(const std::string& name)
+{
+    for (const auto& key : KEY_NAMES) {
+        if (strcasecmp(key.name, name.c_str()) == 0) {
+            return key.code;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Key codes a native action can press, each listed once. The continuous
+ * zoom keys are part of the key names
+ *
+ * @return key codes
+ */
+std::vector<uint16_t> gebaar::action::native_key_codes()
+{
+    std::vector<uint16_t> codes;
+    for (const auto& key : KEY_NAMES) {
+        if (std::find(codes.begin(), codes.end(), key.code) == codes.end()) {
+            codes.push_back(key.code);
+        }
+    }
+    return codes;
+}
+
+/**
+ * Parse the payload of a native action
+ *
+ * @param name action name, "key" or "scroll"
+ * @param payload "ctrl+alt+right" for keys, a direction and optional positive
+ * click count like "down 3" for scrolling
+ * @param action parsed action
+ * @return false if the name is no native action or the payload is invalid
+ */
+bool gebaar::action::parse_native(const std::string& name, const std::string& payload, native_action& action)
+{
+    action = native_action{};
+    if (name == "key") {
+        size_t start = 0;
+        while (start <= payload.size()) {
+            size_t end = payload.find('+', start);
+            uint16_t code = key_code(payload.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (code == 0 || action.key_count == NATIVE_MAX_KEYS) {
+                return false;
+            }
+            action.keys[action.key_count++] = code;
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        action.kind = NATIVE_KEY;
+        return true;
+    }
+    if (name == "scroll") {
+        std::istringstream words(payload);
+        std::string direction;
+        int clicks = 1;
+        words >> direction;
+        if (words >> clicks) {
+            if (clicks <= 0) {
+                return false;
+            }
+        } else if (!words.eof()) {
+            return false;
+        }
+        if (direction == "up") {
+            action.scroll_y = clicks;
+        } else if (direction == "down") {
+            action.scroll_y = -clicks;
+        } else if (direction == "right") {
+            action.scroll_x = clicks;
+        } else if (direction == "left") {
+            action.scroll_x = -clicks;
+        } else {
+            return false;
+        }
+        action.kind = NATIVE_SCROLL;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_NATIVE_H
+#define GEBAAR_NATIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define NATIVE_MAX_KEYS         6
+
+namespace gebaar::action {
+    enum native_kind {NATIVE_NONE, NATIVE_KEY, NATIVE_SCROLL};
+
+    /**
+     * An action injected through uinput instead of running a program,
+     * written "@key ctrl+alt+right" or "@scroll down 3". Key names are
+     * resolved to key codes once, when the configuration is loaded
+     */
+    struct native_action {
+        native_kind kind;
+        uint16_t keys[NATIVE_MAX_KEYS];     // pressed in order, released in reverse
+        uint8_t key_count;
+        int scroll_x;                       // wheel clicks, right positive
+        int scroll_y;                       // wheel clicks, up positive
+    };
+
+    bool parse_native(const std::string& name, const std::string& payload, native_action& action);
+
+    std::vector<uint16_t> native_key_codes();
+}
+
+#endif //GEBAAR_NATIVE_H
@@ -0,0 +1,156 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include "scheduler.h"
+
+/**
+ * A binding was triggered, decide whether it runs now
+ *
+ * @param command bound command, its policy applies
+ * @param group gesture the command belongs to, handed back by expire()
+ * @param time_usec when the triggering event happened
+ * @param values gesture parameters, handed back by expire()
+ * @return number of steps to run now, 0 if held back or dropped
+ */
+unsigned int gebaar::action::Scheduler::trigger(const Command& command, int group, uint64_t time_usec,
+                                                const template_values& values)
+{
+    const rate_policy& policy = command.get_policy();
+    auto& state = bindings.try_emplace(&command, binding_state{group, false, 0, policy.burst, time_usec, 0, 0, values})
+            .first->second;
+    state.group = group;
+    state.values = values;
+    refill(state, policy, time_usec);
+    ++state.pending;
+
+    // Debouncing runs on the trailing edge, once the triggers stopped
+    if (policy.debounce_usec > 0) {
+        state.due_usec = time_usec + policy.debounce_usec;
+        return 0;
+    }
+    uint64_t allowed = allowed_at(state, policy);
+    if (allowed <= time_usec) {
+        return run(state, policy, time_usec);
+    }
+    if (policy.collapse) {
+        state.due_usec = allowed;
+    } else {
+        state.pending = 0;
+    }
+    return 0;
+}
+
+/**
+ * Run every binding whose held back steps are due
+ *
+ * @param time_usec current time
+ * @param run called with every command to run, the values carry its step
+ * count
+ */
+void gebaar::action::Scheduler::expire(uint64_t time_usec, const runner& run)
+{
+    for (auto& binding : bindings) {
+        binding_state& state = binding.second;
+        if (state.pending == 0 || state.due_usec == 0 || state.due_usec > time_usec) {
+            continue;
+        }
+        const rate_policy& policy = binding.first->get_policy();
+        refill(state, policy, time_usec);
+        uint64_t allowed = allowed_at(state, policy);
+        if (allowed > time_usec) {
+            state.due_usec = allowed;
+            continue;
+        }
+        state.values.steps = Scheduler::run(state, policy, time_usec);
+        run(*binding.first, state.group, state.values);
+    }
+}
+
+/**
+ * When expire() has something to run next
+ *
+ * @return time in microseconds, 0 if nothing is held back
+ */
+uint64_t gebaar::action::Scheduler::next_due() const
+{
+    uint64_t due = 0;
+    for (const auto& binding : bindings) {
+        const binding_state& state = binding.second;
+        if (state.pending > 0 && state.due_usec != 0 && (due == 0 || state.due_usec < due)) {
+            due = state.due_usec;
+        }
+    }
+    return due;
+}
+
+/**
+ * Put the tokens back that accumulated since the last refill
+ *
+ * @param state binding state
+ * @param policy binding policy
+ * @param time_usec current time
+ */
+void gebaar::action::Scheduler::refill(binding_state& state, const rate_policy& policy, uint64_t time_usec)
+{
+    if (policy.rate > 0 && time_usec > state.refill_usec) {
+        state.tokens = std::min(policy.burst, state.tokens + (time_usec - state.refill_usec) * policy.rate / 1e6);
+        state.refill_usec = time_usec;
+    }
+}
+
+/**
+ * Earliest time the binding may run again, after the minimum interval and
+ * once a token is available
+ *
+ * @param state binding state
+ * @param policy binding policy
+ * @return time in microseconds
+ */
+uint64_t gebaar::action::Scheduler::allowed_at(const binding_state& state, const rate_policy& policy)
+{
+    uint64_t allowed = 0;
+    if (state.ran && policy.min_interval_usec > 0) {
+        allowed = state.last_run_usec + policy.min_interval_usec;
+    }
+    if (policy.rate > 0 && state.tokens < 1) {
+        allowed = std::max(allowed, state.refill_usec + static_cast<uint64_t>((1 - state.tokens) / policy.rate * 1e6));
+    }
+    return allowed;
+}
+
+/**
+ * Account for a run of the binding
+ *
+ * @param state binding state
+ * @param policy binding policy
+ * @param time_usec time of the run
+ * @return number of steps the run stands for
+ */
+unsigned int gebaar::action::Scheduler::run(binding_state& state, const rate_policy& policy, uint64_t time_usec)
+{
+    unsigned int steps = policy.collapse ? state.pending : 1;
+    state.pending = 0;
+    state.due_usec = 0;
+    state.ran = true;
+    state.last_run_usec = time_usec;
+    if (policy.rate > 0) {
+        state.tokens = std::max(0.0, state.tokens - 1);
+    }
+    return steps;
+}
@@ -0,0 +1,71 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_SCHEDULER_H
+#define GEBAAR_SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "command.h"
+
+namespace gebaar::action {
+    /**
+     * Enforces the rate_policy of bindings. Decisions are made on event
+     * timestamps, so a backlog of events is judged by when the gestures
+     * happened rather than when we got to them. Steps that are held back
+     * wait for expire(), which the main loop calls from a timer at
+     * next_due(), with the parameters of the gesture that triggered them
+     * last. Bindings are told apart by the address of their command,
+     * so the scheduler has to be cleared whenever the configuration changes.
+     */
+    class Scheduler {
+    public:
+        using runner = std::function<void(const Command& command, int group, const template_values& values)>;
+
+        unsigned int trigger(const Command& command, int group, uint64_t time_usec, const template_values& values);
+
+        void expire(uint64_t time_usec, const runner& run);
+
+        uint64_t next_due() const;
+
+        void clear() { bindings.clear(); }
+
+    private:
+        struct binding_state {
+            int group;
+            bool ran;
+            uint64_t last_run_usec;
+            double tokens;
+            uint64_t refill_usec;
+            unsigned int pending;   // steps not run yet
+            uint64_t due_usec;      // when to run them, 0 for never
+            template_values values; // of the latest trigger
+        };
+
+        std::unordered_map<const Command*, binding_state> bindings;
+
+        static void refill(binding_state& state, const rate_policy& policy, uint64_t time_usec);
+
+        static uint64_t allowed_at(const binding_state& state, const rate_policy& policy);
+
+        static unsigned int run(binding_state& state, const rate_policy& policy, uint64_t time_usec);
+    };
+}
+
+#endif //GEBAAR_SCHEDULER_H
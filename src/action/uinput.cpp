@@ -0,0 +1,174 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "uinput.h"
+
+/**
+ * Create the virtual device. It can send the keys native actions name
+ * and both wheels, in clicks and in high resolution units. Button codes
+ * are left out, so the device is classified as a plain keyboard
+ *
+ * @return bool false if /dev/uinput can't be opened or set up
+ */
+bool gebaar::action::VirtualInput::initialize()
+{
+    if (fd >= 0) {
+        return true;
+    }
+    fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Cannot open /dev/uinput: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 && ioctl(fd, UI_SET_EVBIT, EV_REL) == 0
+              && ioctl(fd, UI_SET_EVBIT, EV_SYN) == 0;
+    for (uint16_t key : native_key_codes()) {
+        ok = ok && ioctl(fd, UI_SET_KEYBIT, key) == 0;
+    }
+    for (int axis : {REL_WHEEL, REL_HWHEEL, REL_WHEEL_HI_RES, REL_HWHEEL_HI_RES}) {
+        ok = ok && ioctl(fd, UI_SET_RELBIT, axis) == 0;
+    }
+
+    struct uinput_setup setup{};
+    setup.id.bustype = BUS_VIRTUAL;
+    strncpy(setup.name, UINPUT_DEVICE_NAME, UINPUT_MAX_NAME_SIZE - 1);
+    if (!ok || ioctl(fd, UI_DEV_SETUP, &setup) != 0 || ioctl(fd, UI_DEV_CREATE) != 0) {
+        std::cerr << "Cannot create the uinput device: " << strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+gebaar::action::VirtualInput::~VirtualInput()
+{
+    if (fd >= 0) {
+        ioctl(fd, UI_DEV_DESTROY);
+        close(fd);
+    }
+}
+
+/**
+ * Inject a native action. All events go out in a single write
+ *
+ * @param action action to inject
+ * @param repeat how often to press the keys, multiplies the scroll clicks
+ * @return bool false if the device is missing or the write failed
+ */
+bool gebaar::action::VirtualInput::send(const native_action& action, unsigned int repeat)
+{
+    if (fd < 0) {
+        return false;
+    }
+    struct input_event events[UINPUT_MAX_EVENTS]{};
+    size_t count = 0;
+    auto add = [&events, &count](uint16_t type, uint16_t code, int value) {
+        events[count].type = type;
+        events[count].code = code;
+        events[count].value = value;
+        ++count;
+    };
+
+    if (action.kind == NATIVE_KEY) {
+        // Every repetition takes a press and a release per key and two syncs
+        size_t room = UINPUT_MAX_EVENTS / (2 * action.key_count + 2);
+        for (unsigned int i = 0; i < repeat && i < room; ++i) {
+            for (uint8_t key = 0; key < action.key_count; ++key) {
+                add(EV_KEY, action.keys[key], 1);
+            }
+            add(EV_SYN, SYN_REPORT, 0);
+            for (uint8_t key = action.key_count; key-- > 0;) {
+                add(EV_KEY, action.keys[key], 0);
+            }
+            add(EV_SYN, SYN_REPORT, 0);
+        }
+    } else if (action.kind == NATIVE_SCROLL) {
+        int clicks_x = action.scroll_x * static_cast<int>(repeat);
+        int clicks_y = action.scroll_y * static_cast<int>(repeat);
+        if (clicks_y != 0) {
+            add(EV_REL, REL_WHEEL, clicks_y);
+            add(EV_REL, REL_WHEEL_HI_RES, clicks_y * 120);
+        }
+        if (clicks_x != 0) {
+            add(EV_REL, REL_HWHEEL, clicks_x);
+            add(EV_REL, REL_HWHEEL_HI_RES, clicks_x * 120);
+        }
+        add(EV_SYN, SYN_REPORT, 0);
+    }
+    ssize_t size = static_cast<ssize_t>(count * sizeof(events[0]));
+    return write(fd, events, size) == size;
+}
+
+/**
+ * Move the wheels, in high resolution units and legacy clicks
+ *
+ * @param units_x high resolution units to the right
+ * @param units_y high resolution units up
+ * @param clicks_x clicks to the right
+ * @param clicks_y clicks up
+ * @param held_key key held during the movement, 0 for none
+ * @return bool false if the device is missing or the write failed
+ */
+bool gebaar::action::VirtualInput::send_wheel(int units_x, int units_y, int clicks_x, int clicks_y,
+                                              uint16_t held_key)
+{
+    if (fd < 0) {
+        return false;
+    }
+    struct input_event events[8]{};
+    size_t count = 0;
+    auto add = [&events, &count](uint16_t type, uint16_t code, int value) {
+        events[count].type = type;
+        events[count].code = code;
+        events[count].value = value;
+        ++count;
+    };
+
+    if (held_key != 0) {
+        add(EV_KEY, held_key, 1);
+        add(EV_SYN, SYN_REPORT, 0);
+    }
+    if (units_y != 0) {
+        add(EV_REL, REL_WHEEL_HI_RES, units_y);
+    }
+    if (clicks_y != 0) {
+        add(EV_REL, REL_WHEEL, clicks_y);
+    }
+    if (units_x != 0) {
+        add(EV_REL, REL_HWHEEL_HI_RES, units_x);
+    }
+    if (clicks_x != 0) {
+        add(EV_REL, REL_HWHEEL, clicks_x);
+    }
+    add(EV_SYN, SYN_REPORT, 0);
+    if (held_key != 0) {
+        add(EV_KEY, held_key, 0);
+        add(EV_SYN, SYN_REPORT, 0);
+    }
+    ssize_t size = static_cast<ssize_t>(count * sizeof(events[0]));
+    return write(fd, events, size) == size;
+}
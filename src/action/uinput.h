@@ -0,0 +1,51 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_UINPUT_H
+#define GEBAAR_UINPUT_H
+
+#include <cstdint>
+#include "native.h"
+
+#define UINPUT_DEVICE_NAME      "gebaar virtual input"
+#define UINPUT_MAX_EVENTS       64
+
+namespace gebaar::action {
+    /**
+     * A virtual keyboard and wheel created once through /dev/uinput, so a
+     * native action costs one write() instead of a fork+exec and a round
+     * trip to the display server
+     */
+    class VirtualInput {
+    public:
+        ~VirtualInput();
+
+        bool initialize();
+
+        bool is_open() const { return fd >= 0; }
+
+        bool send(const native_action& action, unsigned int repeat);
+
+        bool send_wheel(int units_x, int units_y, int clicks_x, int clicks_y, uint16_t held_key);
+
+    private:
+        int fd = -1;
+    };
+}
+
+#endif //GEBAAR_UINPUT_H
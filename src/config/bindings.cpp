@@ -0,0 +1,75 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bindings.h"
+
+/**
+ * Create an empty table, every slot points at the empty action
+ */
+gebaar::config::BindingTable::BindingTable()
+        :actions(1),
+         slots(gebaar::gesture::GESTURE_TYPE_COUNT * BINDING_MAX_FINGERS * BINDING_DIRECTIONS
+               * gebaar::gesture::MODIFIER_COMBINATIONS, 0)
+{
+}
+
+/**
+ * Bind a command to a slot, replacing whatever was bound there
+ *
+ * @param type gesture type
+ * @param fingers finger count
+ * @param direction swipe_type or pinch direction
+ * @param modifiers keyboard modifiers that have to be held
+ * @param command command to bind
+ */
+void gebaar::config::BindingTable::bind(gebaar::gesture::gesture_type type, int fingers, int direction,
+                                        unsigned int modifiers, gebaar::action::Command command)
+{
+    if (fingers < 0 || fingers >= BINDING_MAX_FINGERS || direction < 0 || direction >= BINDING_DIRECTIONS
+        || modifiers >= gebaar::gesture::MODIFIER_COMBINATIONS || command.empty()) {
+        return;
+    }
+    if (command.is_native()) {
+        ++native_bindings;
+    }
+    actions.push_back(std::move(command));
+    slots[index(type, fingers, direction, modifiers)] = static_cast<uint16_t>(actions.size() - 1);
+    if (modifiers != 0) {
+        ++modifier_bindings;
+    }
+}
+
+/**
+ * Check whether anything is bound to a direction, for any finger count and
+ * modifiers. Meant for load time, it looks at every slot of the direction
+ *
+ * @param type gesture type
+ * @param direction swipe_type or pinch direction
+ * @return bool
+ */
+bool gebaar::config::BindingTable::binds(gebaar::gesture::gesture_type type, int direction) const
+{
+    for (int fingers = 0; fingers < BINDING_MAX_FINGERS; ++fingers) {
+        for (unsigned int modifiers = 0; modifiers < gebaar::gesture::MODIFIER_COMBINATIONS; ++modifiers) {
+            if (slots[index(type, fingers, direction, modifiers)] != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
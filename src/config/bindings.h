@@ -0,0 +1,74 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_BINDINGS_H
+#define GEBAAR_BINDINGS_H
+
+#include <cstdint>
+#include <vector>
+#include "../action/command.h"
+#include "../gesture/event.h"
+
+#define BINDING_MAX_FINGERS     8
+#define BINDING_DIRECTIONS      10
+
+namespace gebaar::config {
+    /**
+     * Every binding of a configuration compiled into one flat table indexed
+     * by (gesture type, finger count, direction, modifiers). Slots hold
+     * handles into the action list, handle 0 is the empty action, so a
+     * lookup is a single indexed load without any branching on fingers.
+     */
+    class BindingTable {
+    public:
+        BindingTable();
+
+        void bind(gebaar::gesture::gesture_type type, int fingers, int direction, unsigned int modifiers,
+                  gebaar::action::Command command);
+
+        const gebaar::action::Command& lookup(gebaar::gesture::gesture_type type, int fingers, int direction,
+                                              unsigned int modifiers) const
+        {
+            if (fingers < 0 || fingers >= BINDING_MAX_FINGERS || direction < 0 || direction >= BINDING_DIRECTIONS
+                || modifiers >= gebaar::gesture::MODIFIER_COMBINATIONS) {
+                return actions[0];
+            }
+            return actions[slots[index(type, fingers, direction, modifiers)]];
+        }
+
+        bool uses_modifiers() const { return modifier_bindings > 0; }
+
+        bool uses_native() const { return native_bindings > 0; }
+
+        bool binds(gebaar::gesture::gesture_type type, int direction) const;
+
+    private:
+        std::vector<gebaar::action::Command> actions;
+        std::vector<uint16_t> slots;
+        size_t modifier_bindings = 0;
+        size_t native_bindings = 0;
+
+        static size_t index(gebaar::gesture::gesture_type type, int fingers, int direction, unsigned int modifiers)
+        {
+            return ((static_cast<size_t>(type) * BINDING_MAX_FINGERS + fingers) * BINDING_DIRECTIONS + direction)
+                   * gebaar::gesture::MODIFIER_COMBINATIONS + modifiers;
+        }
+    };
+}
+
+#endif //GEBAAR_BINDINGS_H
@@ -17,10 +17,49 @@
 */
 
 
+#include <algorithm>
+#include <sstream>
 #include <zconf.h>
 #include "config.h"
 #include "../util.h"
 
+/**
+ * Direction keys of swipe commands, indexed by swipe_type
+ */
+static const char* const SWIPE_DIRECTIONS[BINDING_DIRECTIONS] = {nullptr, "left_up", "up", "right_up", "left", nullptr,
+                                                                 "right", "left_down", "down", "right_down"};
+
+/**
+ * Direction keys of pinch commands, indexed by Config::pinch. Growing the
+ * scale has always run the "out" command
+ */
+static const char* const PINCH_DIRECTIONS[BINDING_DIRECTIONS] = {"out", "in", "rotate_cw", "rotate_ccw"};
+
+/**
+ * Direction keys of hold and touchscreen commands, indexed by Config::hold
+ * and Config::touch
+ */
+static const char* const HOLD_DIRECTIONS[BINDING_DIRECTIONS] = {"hold"};
+static const char* const TOUCH_DIRECTIONS[BINDING_DIRECTIONS] = {"tap", "left_edge", "right_edge", "top_edge",
+                                                                 "bottom_edge"};
+
+/**
+ * Thresholds are divided by, a value that isn't positive falls back
+ *
+ * @param value configured threshold
+ * @param fallback default threshold
+ * @param name setting name, for the warning
+ * @return value or fallback
+ */
+static double positive(double value, double fallback, const std::string& name)
+{
+    if (value > 0) {
+        return value;
+    }
+    std::cerr << name << " must be greater than 0, using " << fallback << std::endl;
+    return fallback;
+}
+
 /**
  * Check if config file exists at current path
  */
@@ -32,53 +71,398 @@ bool gebaar::config::Config::config_file_exists()
 
 /**
  * Load Configuration from TOML file
+ *
+ * @return false if the file exists but could not be parsed
  */
-void gebaar::config::Config::load_config()
+bool gebaar::config::Config::load_config()
 {
-    if (find_config_file()) {
+    if (!config_file_path.empty()) {
         if (config_file_exists()) {
             try {
                 config = cpptoml::parse_file(std::filesystem::path(config_file_path));
             } catch (const cpptoml::parse_exception& e) {
                 std::cerr << e.what() << std::endl;
-                exit(EXIT_FAILURE);
+                return false;
             }
 
+            /* Bindings */
+            bindings = BindingTable();
+            load_bindings("swipe.commands", gebaar::gesture::GESTURE_SWIPE, SWIPE_DIRECTIONS);
+            load_bindings("pinch.commands", gebaar::gesture::GESTURE_PINCH, PINCH_DIRECTIONS);
+            load_bindings("hold.commands", gebaar::gesture::GESTURE_HOLD, HOLD_DIRECTIONS);
+            load_bindings("touch.commands", gebaar::gesture::GESTURE_TOUCH, TOUCH_DIRECTIONS);
+            load_sequences();
+
             /* Swipe Settings */
-            swipe_three_commands[1] = *config->get_qualified_as<std::string>("swipe.commands.three.left_up");
-            swipe_three_commands[2] = *config->get_qualified_as<std::string>("swipe.commands.three.up");
-            swipe_three_commands[3] = *config->get_qualified_as<std::string>("swipe.commands.three.right_up");
-            swipe_three_commands[4] = *config->get_qualified_as<std::string>("swipe.commands.three.left");
-            swipe_three_commands[6] = *config->get_qualified_as<std::string>("swipe.commands.three.right");
-            swipe_three_commands[7] = *config->get_qualified_as<std::string>("swipe.commands.three.left_down");
-            swipe_three_commands[8] = *config->get_qualified_as<std::string>("swipe.commands.three.down");
-            swipe_three_commands[9] = *config->get_qualified_as<std::string>("swipe.commands.three.right_down");
-
-            swipe_four_commands[1] = *config->get_qualified_as<std::string>("swipe.commands.four.left_up");
-            swipe_four_commands[2] = *config->get_qualified_as<std::string>("swipe.commands.four.up");
-            swipe_four_commands[3] = *config->get_qualified_as<std::string>("swipe.commands.four.right_up");
-            swipe_four_commands[4] = *config->get_qualified_as<std::string>("swipe.commands.four.left");
-            swipe_four_commands[6] = *config->get_qualified_as<std::string>("swipe.commands.four.right");
-            swipe_four_commands[7] = *config->get_qualified_as<std::string>("swipe.commands.four.left_down");
-            swipe_four_commands[8] = *config->get_qualified_as<std::string>("swipe.commands.four.down");
-            swipe_four_commands[9] = *config->get_qualified_as<std::string>("swipe.commands.four.right_down");
-
-            settings.swipe_threshold = config->get_qualified_as<double>("swipe.settings.threshold").value_or(0.5);
+            settings.swipe_threshold = positive(config->get_qualified_as<double>("swipe.settings.threshold")
+                    .value_or(0.5), 0.5, "swipe.settings.threshold");
+            settings.swipe_threshold_mm = config->get_qualified_as<double>("swipe.settings.threshold_mm").value_or(0);
+            settings.swipe_threshold_fraction = config->get_qualified_as<double>("swipe.settings.threshold_fraction")
+                    .value_or(0);
             settings.swipe_one_shot = config->get_qualified_as<bool>("swipe.settings.one_shot").value_or(true);
             settings.swipe_trigger_on_release = config->get_qualified_as<bool>("swipe.settings.trigger_on_release").value_or(true);
+            settings.swipe_early_recognition = config->get_qualified_as<bool>("swipe.settings.early_recognition")
+                    .value_or(false);
+            settings.swipe_early_velocity = config->get_qualified_as<double>("swipe.settings.early_velocity")
+                    .value_or(150);
+            settings.swipe_max_in_flight = config->get_qualified_as<unsigned int>("swipe.settings.max_in_flight").value_or(0);
 
             /* Pinch settings */
-            pinch_commands[PINCH_IN] = *config->get_qualified_as<std::string>("pinch.commands.two.out");
-            pinch_commands[PINCH_OUT] = *config->get_qualified_as<std::string>("pinch.commands.two.in");
-
-            settings.pinch_threshold = config->get_qualified_as<double>("pinch.settings.threshold").value_or(0.25);
+            settings.pinch_threshold = positive(config->get_qualified_as<double>("pinch.settings.threshold")
+                    .value_or(0.25), 0.25, "pinch.settings.threshold");
             settings.pinch_one_shot = config->get_qualified_as<bool>("pinch.settings.one_shot").value_or(false);
+            settings.pinch_max_in_flight = config->get_qualified_as<unsigned int>("pinch.settings.max_in_flight").value_or(0);
+            settings.rotate_threshold = positive(config->get_qualified_as<double>("pinch.settings.rotate_threshold")
+                    .value_or(15), 15, "pinch.settings.rotate_threshold");
+            settings.rotate_one_shot = config->get_qualified_as<bool>("pinch.settings.rotate_one_shot").value_or(false);
+            // Without rotate bindings every pinch is just a pinch
+            settings.pinch_rotate = bindings.binds(gebaar::gesture::GESTURE_PINCH, ROTATE_CW)
+                                    || bindings.binds(gebaar::gesture::GESTURE_PINCH, ROTATE_CCW);
+
+            /* Gesture event bus */
+            settings.bus_enabled = config->get_qualified_as<bool>("bus.enabled").value_or(false);
+            settings.bus_socket = config->get_qualified_as<std::string>("bus.socket")
+                    .value_or(gebaar::util::runtimePath("events.sock"));
+
+            /* Gesture progress stream */
+            settings.stream_enabled = config->get_qualified_as<bool>("stream.enabled").value_or(false);
+            settings.stream_socket = config->get_qualified_as<std::string>("stream.socket")
+                    .value_or(gebaar::util::runtimePath("stream.sock"));
+            settings.stream_rate = config->get_qualified_as<unsigned int>("stream.rate").value_or(60);
+
+            /* Input settings */
+            settings.input_backend = config->get_qualified_as<std::string>("input.backend").value_or("udev");
+            settings.input_devices = config->get_qualified_array_of<std::string>("input.devices")
+                    .value_or(std::vector<std::string>());
+            if (settings.input_backend != "udev" && settings.input_backend != "path") {
+                std::cerr << "Unknown input backend " << settings.input_backend << ", using udev" << std::endl;
+                settings.input_backend = "udev";
+            }
+
+            /* Hold and touchscreen settings */
+            settings.hold_duration = config->get_qualified_as<unsigned int>("hold.settings.duration").value_or(300);
+            settings.tap_timeout = config->get_qualified_as<unsigned int>("touch.settings.tap_timeout").value_or(250);
+            settings.tap_distance = config->get_qualified_as<double>("touch.settings.tap_distance").value_or(0.02);
+            settings.edge_zone = config->get_qualified_as<double>("touch.settings.edge_zone").value_or(0.05);
+            settings.edge_distance = config->get_qualified_as<double>("touch.settings.edge_distance").value_or(0.1);
+
+            /* Sequence settings */
+            settings.sequence_timeout = config->get_qualified_as<unsigned int>("sequence.settings.timeout")
+                    .value_or(600);
+
+            /* Continuous output */
+            // The flush delay is in whole microseconds and must not round to zero, which disarms the timer
+            settings.continuous_rate = std::clamp(config->get_qualified_as<unsigned int>("continuous.rate")
+                    .value_or(120), 1u, 1000u);
+            settings.scroll_fingers = config->get_qualified_as<int>("continuous.scroll_fingers").value_or(0);
+            settings.scroll_speed = config->get_qualified_as<double>("continuous.scroll_speed").value_or(24);
+            settings.scroll_natural = config->get_qualified_as<bool>("continuous.scroll_natural").value_or(false);
+            settings.zoom_fingers = config->get_qualified_as<int>("continuous.zoom_fingers").value_or(0);
+            settings.zoom_speed = config->get_qualified_as<double>("continuous.zoom_speed").value_or(4);
+            settings.zoom_keys = config->get_qualified_as<bool>("continuous.zoom_keys").value_or(false);
+
+            /* Per device settings */
+            devices.clear();
+            if (auto device_table = config->get_table("devices")) {
+                for (const auto& device : *device_table) {
+                    if (!device.second->is_table()) {
+                        continue;
+                    }
+                    auto table = device.second->as_table();
+                    devices[device.first] = {
+                            table->get_as<double>("scale").value_or(1.0),
+                            positive(table->get_as<double>("swipe_threshold").value_or(settings.swipe_threshold),
+                                     settings.swipe_threshold, device.first + ".swipe_threshold"),
+                            table->get_as<double>("swipe_threshold_mm").value_or(settings.swipe_threshold_mm),
+                            table->get_as<double>("swipe_threshold_fraction")
+                                    .value_or(settings.swipe_threshold_fraction),
+                            positive(table->get_as<double>("pinch_threshold").value_or(settings.pinch_threshold),
+                                     settings.pinch_threshold, device.first + ".pinch_threshold")};
+                }
+            }
+
+            /* Persistent helpers */
+            helpers.clear();
+            if (auto helper_table = config->get_table("helpers")) {
+                for (const auto& helper : *helper_table) {
+                    if (auto command = helper.second->as<std::string>()) {
+                        helpers.emplace(helper.first, gebaar::action::Command(command->get()));
+                    }
+                }
+            }
 
 
             loaded = true;
         }
     }
+    return true;
+}
+
+/**
+ * Compile every binding below a commands table into the binding table.
+ * Finger counts are sub tables ("three" or "3"), which hold direction keys
+ * directly and modifier tables ("ctrl", "ctrl+shift") with direction keys.
+ * A direction is either a command or a table with a command and its limits
+ *
+ * @param key qualified key of the commands table
+ * @param type gesture type the commands are bound to
+ * @param directions config key of every direction, indexed by direction
+ */
+void gebaar::config::Config::load_bindings(const std::string& key, gebaar::gesture::gesture_type type,
+                                           const char* const directions[BINDING_DIRECTIONS])
+{
+    auto commands = config->get_table_qualified(key);
+    if (!commands) {
+        return;
+    }
+    for (const auto& finger_entry : *commands) {
+        int fingers = parse_fingers(finger_entry.first);
+        if (fingers < 0 || !finger_entry.second->is_table()) {
+            std::cerr << "Ignoring " << key << "." << finger_entry.first << std::endl;
+            continue;
+        }
+        for (const auto& entry : *finger_entry.second->as_table()) {
+            // Tables are modifiers, unless they are a direction with limits
+            int modifiers = entry.second->is_table() ? parse_modifiers(entry.first) : -1;
+            if (modifiers > 0) {
+                for (const auto& modified : *entry.second->as_table()) {
+                    bind(type, fingers, modifiers, modified.first, modified.second, directions);
+                }
+            } else {
+                bind(type, fingers, 0, entry.first, entry.second, directions);
+            }
+        }
+    }
+}
+
+/**
+ * Bind one direction key
+ *
+ * @param type gesture type
+ * @param fingers finger count
+ * @param modifiers keyboard modifiers
+ * @param direction_key config key of the direction
+ * @param value configured command
+ * @param directions config key of every direction, indexed by direction
+ */
+void gebaar::config::Config::bind(gebaar::gesture::gesture_type type, int fingers, int modifiers,
+                                  const std::string& direction_key, const std::shared_ptr<cpptoml::base>& value,
+                                  const char* const directions[BINDING_DIRECTIONS])
+{
+    gebaar::action::Command command;
+    bool parsed = false;
+    if (auto line = value->as<std::string>()) {
+        command = gebaar::action::Command(line->get());
+        parsed = true;
+    } else if (value->is_table()) {
+        parsed = parse_command(*value->as_table(), command);
+    }
+    for (int direction = 0; direction < BINDING_DIRECTIONS; ++direction) {
+        if (parsed && directions[direction] != nullptr && direction_key == directions[direction]) {
+            bindings.bind(type, fingers, direction, modifiers, std::move(command));
+            return;
+        }
+    }
+    std::cerr << "Ignoring binding " << direction_key << std::endl;
+}
+
+/**
+ * Compile the [[sequence.commands]] tables into the sequence DFA. Each has
+ * a list of gestures and a command with optional limits, a gesture in the
+ * list can be a chord of gestures joined by "+"
+ */
+void gebaar::config::Config::load_sequences()
+{
+    sequences = SequenceTable();
+    auto tables = config->get_table_array_qualified("sequence.commands");
+    if (!tables) {
+        return;
+    }
+    for (const auto& sequence : *tables) {
+        auto gestures = sequence->get_array_of<std::string>("gestures");
+        gebaar::action::Command command;
+        if (!gestures || !parse_command(*sequence, command)) {
+            std::cerr << "Ignoring sequence without gestures or command" << std::endl;
+            continue;
+        }
+        std::vector<std::vector<sequence_gesture>> steps;
+        bool valid = true;
+        for (const auto& step : *gestures) {
+            steps.emplace_back();
+            size_t start = 0;
+            while (valid && start <= step.size()) {
+                size_t end = step.find('+', start);
+                sequence_gesture gesture{};
+                valid = parse_gesture(step.substr(start, end == std::string::npos ? std::string::npos : end - start),
+                                      gesture);
+                steps.back().push_back(gesture);
+                if (end == std::string::npos) {
+                    break;
+                }
+                start = end + 1;
+            }
+            if (!valid) {
+                std::cerr << "Unknown gesture in sequence: " << step << std::endl;
+                break;
+            }
+        }
+        if (valid && !sequences.add(steps, command)) {
+            std::cerr << "Ignoring sequence " << command.get_line() << std::endl;
+        }
+    }
+    if (!sequences.compile()) {
+        std::cerr << "Too many sequences, ignoring all of them" << std::endl;
+        sequences = SequenceTable();
+    }
+}
+
+/**
+ * Command of a binding table along with its limits, all in milliseconds
+ * but the rate, which is in runs per second
+ *
+ * @param table binding table
+ * @param command parsed command
+ * @return false if the table has no command
+ */
+bool gebaar::config::Config::parse_command(const cpptoml::table& table, gebaar::action::Command& command)
+{
+    auto line = table.get_as<std::string>("command");
+    if (!line) {
+        return false;
+    }
+    command = gebaar::action::Command(*line);
+    gebaar::action::rate_policy policy{};
+    policy.debounce_usec = table.get_as<unsigned int>("debounce").value_or(0) * 1000ull;
+    policy.min_interval_usec = table.get_as<unsigned int>("min_interval").value_or(0) * 1000ull;
+    policy.rate = table.get_as<double>("rate").value_or(0);
+    policy.burst = std::max(1.0, table.get_as<double>("burst").value_or(1));
+    policy.collapse = table.get_as<bool>("collapse").value_or(false);
+    command.set_policy(policy);
+    return true;
+}
+
+/**
+ * Gesture of a sequence, written like "swipe three up", "pinch two in",
+ * "hold four" or "touch one left_edge"
+ *
+ * @param text gesture description
+ * @param gesture parsed gesture
+ * @return false if the text names no gesture
+ */
+bool gebaar::config::Config::parse_gesture(const std::string& text, sequence_gesture& gesture)
+{
+    std::istringstream words(text);
+    std::string type, fingers, direction;
+    words >> type >> fingers >> direction;
+    if (direction.empty() && type == "hold") {
+        direction = HOLD_DIRECTIONS[HOLD];
+    }
+    for (int candidate = 0; candidate < gebaar::gesture::GESTURE_TYPE_COUNT; ++candidate) {
+        auto gesture_type = static_cast<gebaar::gesture::gesture_type>(candidate);
+        if (type != gebaar::gesture::gesture_name(gesture_type)) {
+            continue;
+        }
+        gesture.type = gesture_type;
+        gesture.fingers = parse_fingers(fingers);
+        for (int index = 0; index < BINDING_DIRECTIONS; ++index) {
+            const char* name = direction_name(gesture_type, index);
+            if (name != nullptr && direction == name) {
+                gesture.direction = index;
+                return gesture.fingers > 0;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Finger count of a commands sub table, either spelled out or a number
+ *
+ * @param key table name
+ * @return finger count or -1 if unknown
+ */
+int gebaar::config::Config::parse_fingers(const std::string& key)
+{
+    static const char* const names[BINDING_MAX_FINGERS] = {nullptr, "one", "two", "three", "four", "five", "six",
+                                                            "seven"};
+    for (int fingers = 1; fingers < BINDING_MAX_FINGERS; ++fingers) {
+        if (key == names[fingers] || key == std::to_string(fingers)) {
+            return fingers;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Modifier mask of a table name like "ctrl+shift"
+ *
+ * @param key table name
+ * @return modifier mask or -1 if a part is unknown
+ */
+int gebaar::config::Config::parse_modifiers(const std::string& key)
+{
+    int modifiers = 0;
+    size_t start = 0;
+    while (start <= key.size()) {
+        size_t end = key.find('+', start);
+        std::string name = key.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (name == "shift") {
+            modifiers |= gebaar::gesture::MODIFIER_SHIFT;
+        } else if (name == "ctrl") {
+            modifiers |= gebaar::gesture::MODIFIER_CTRL;
+        } else if (name == "alt") {
+            modifiers |= gebaar::gesture::MODIFIER_ALT;
+        } else if (name == "super") {
+            modifiers |= gebaar::gesture::MODIFIER_SUPER;
+        } else {
+            return -1;
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return modifiers;
+}
+
+/**
+ * Config key of a gesture direction
+ *
+ * @param type gesture type
+ * @param direction swipe_type or pinch direction
+ * @return key, nullptr for directions without one
+ */
+const char* gebaar::config::Config::direction_name(gebaar::gesture::gesture_type type, int direction)
+{
+    if (direction < 0 || direction >= BINDING_DIRECTIONS) {
+        return nullptr;
+    }
+    switch (type) {
+        case gebaar::gesture::GESTURE_SWIPE:
+            return SWIPE_DIRECTIONS[direction];
+        case gebaar::gesture::GESTURE_PINCH:
+            return PINCH_DIRECTIONS[direction];
+        case gebaar::gesture::GESTURE_HOLD:
+            return HOLD_DIRECTIONS[direction];
+        default:
+            return TOUCH_DIRECTIONS[direction];
+    }
+}
 
+/**
+ * Settings for one touchpad, the global ones unless it has a [devices] table
+ *
+ * @param name device name
+ * @return device settings
+ */
+gebaar::config::Config::device_settings gebaar::config::Config::settings_for_device(const std::string& name) const
+{
+    auto device = devices.find(name);
+    if (device != devices.end()) {
+        return device->second;
+    }
+    return {1.0, settings.swipe_threshold, settings.swipe_threshold_mm, settings.swipe_threshold_fraction,
+            settings.pinch_threshold};
 }
 
 /**
@@ -107,9 +491,30 @@ bool gebaar::config::Config::find_config_file()
     return false;
 }
 
+/**
+ * Parse a configuration file into a new, immutable snapshot. Used for
+ * reloading, so unlike the first load a broken file is not fatal
+ *
+ * @param path configuration file
+ * @return snapshot, nullptr if the file is missing or broken
+ */
+std::shared_ptr<const gebaar::config::Config> gebaar::config::Config::parse(const std::string& path)
+{
+    std::shared_ptr<Config> snapshot(new Config(path));
+    if (!snapshot->load_config() || !snapshot->loaded) {
+        return nullptr;
+    }
+    return snapshot;
+}
+
+gebaar::config::Config::Config(const std::string& path)
+        :config_file_path(path)
+{
+}
+
 gebaar::config::Config::Config()
 {
-    if (!loaded) {
-        load_config();
+    if (!loaded && find_config_file() && !load_config()) {
+        exit(EXIT_FAILURE);
     }
 }
@@ -23,37 +23,124 @@
 #include <filesystem>
 #include <pwd.h>
 #include <iostream>
+#include <map>
+#include <vector>
+#include "../action/command.h"
+#include "../gesture/event.h"
+#include "../util.h"
+#include "bindings.h"
+#include "sequences.h"
 
 namespace gebaar::config {
     class Config {
     public:
         Config();
 
+        static std::shared_ptr<const Config> parse(const std::string& path);
+
+        static const char* direction_name(gebaar::gesture::gesture_type type, int direction);
+
         bool loaded = false;
 
-        void load_config();
+        bool load_config();
+
+        const std::string& get_path() const { return config_file_path; }
 
 
         struct settings {
-          bool pinch_one_shot;
-          double pinch_threshold;
+          bool pinch_one_shot = false;
+          double pinch_threshold = 0.25;
+          unsigned int pinch_max_in_flight = 0;
+          bool pinch_rotate = false;
+          double rotate_threshold = 15;
+          bool rotate_one_shot = false;
+
+          bool swipe_one_shot = true;
+          double swipe_threshold = 0.5;
+          double swipe_threshold_mm = 0;
+          double swipe_threshold_fraction = 0;
+          bool swipe_trigger_on_release = true;
+          bool swipe_early_recognition = false;
+          double swipe_early_velocity = 150;
+          unsigned int swipe_max_in_flight = 0;
+
+          unsigned int hold_duration = 300;
+          unsigned int tap_timeout = 250;
+          double tap_distance = 0.02;
+          double edge_zone = 0.05;
+          double edge_distance = 0.1;
+
+          unsigned int sequence_timeout = 600;
+
+          unsigned int continuous_rate = 120;
+          int scroll_fingers = 0;
+          double scroll_speed = 24;
+          bool scroll_natural = false;
+          int zoom_fingers = 0;
+          double zoom_speed = 4;
+          bool zoom_keys = false;
+
+          bool bus_enabled = false;
+          std::string bus_socket = gebaar::util::runtimePath("events.sock");
+
+          bool stream_enabled = false;
+          std::string stream_socket = gebaar::util::runtimePath("stream.sock");
+          unsigned int stream_rate = 60;
+
+          std::string input_backend = "udev";
+          std::vector<std::string> input_devices;
+        } settings;
 
-          bool swipe_one_shot;
+        /*
+         * Per touchpad overrides, keyed by device name
+         */
+        struct device_settings {
+          double scale;
           double swipe_threshold;
-          bool swipe_trigger_on_release;
-        } settings;
+          double swipe_threshold_mm;
+          double swipe_threshold_fraction;
+          double pinch_threshold;
+        };
+        std::map<std::string, device_settings> devices;
+
+        device_settings settings_for_device(const std::string& name) const;
 
-        enum pinch {PINCH_IN, PINCH_OUT};
-        std::string swipe_three_commands[10];
-        std::string swipe_four_commands[10];
-        std::string pinch_commands[10];
+        bool uses_uinput() const
+        {
+            return bindings.uses_native() || sequences.uses_native() || settings.scroll_fingers > 0
+                   || settings.zoom_fingers > 0;
+        }
+
+        enum pinch {PINCH_IN, PINCH_OUT, ROTATE_CW, ROTATE_CCW};
+        enum hold {HOLD};
+        enum touch {TOUCH_TAP, TOUCH_LEFT_EDGE, TOUCH_RIGHT_EDGE, TOUCH_TOP_EDGE, TOUCH_BOTTOM_EDGE};
+        BindingTable bindings;
+        SequenceTable sequences;
+        std::map<std::string, gebaar::action::Command> helpers;
 
     private:
+        explicit Config(const std::string& path);
 
         bool config_file_exists();
 
         bool find_config_file();
 
+        void load_bindings(const std::string& key, gebaar::gesture::gesture_type type,
+                           const char* const directions[BINDING_DIRECTIONS]);
+
+        void bind(gebaar::gesture::gesture_type type, int fingers, int modifiers, const std::string& direction_key,
+                  const std::shared_ptr<cpptoml::base>& value, const char* const directions[BINDING_DIRECTIONS]);
+
+        void load_sequences();
+
+        static bool parse_command(const cpptoml::table& table, gebaar::action::Command& command);
+
+        static bool parse_gesture(const std::string& text, sequence_gesture& gesture);
+
+        static int parse_fingers(const std::string& key);
+
+        static int parse_modifiers(const std::string& key);
+
 
         std::string config_file_path;
         std::shared_ptr<cpptoml::table> config;
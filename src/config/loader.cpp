@@ -0,0 +1,100 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "loader.h"
+
+/**
+ * Create the eventfd finished snapshots are announced on
+ *
+ * @return bool
+ */
+bool gebaar::config::Loader::initialize()
+{
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return event_fd >= 0;
+}
+
+/**
+ * Parse a configuration file in the background. A request that arrives
+ * while a parse is running makes the worker parse once more afterwards.
+ * The flag is raised before testing busy, so a worker that has just
+ * cleared busy either sees it or has left busy to this request
+ *
+ * @param path configuration file
+ */
+void gebaar::config::Loader::request(const std::string& path)
+{
+    again = true;
+    if (busy.exchange(true)) {
+        return;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    requested_path = path;
+    worker = std::thread(&Loader::work, this);
+}
+
+/**
+ * Fetch the newest parsed snapshot, called when the eventfd is readable
+ *
+ * @return snapshot or nullptr if there is none
+ */
+std::shared_ptr<const gebaar::config::Config> gebaar::config::Loader::take()
+{
+    uint64_t value;
+    if (read(event_fd, &value, sizeof(value)) < 0) {
+        // nothing was announced
+    }
+    return std::atomic_exchange(&pending, std::shared_ptr<const Config>());
+}
+
+/**
+ * Worker thread body
+ */
+void gebaar::config::Loader::work()
+{
+    do {
+        again = false;
+        auto snapshot = Config::parse(requested_path);
+        if (snapshot) {
+            std::atomic_store(&pending, snapshot);
+            uint64_t value = 1;
+            if (write(event_fd, &value, sizeof(value)) < 0) {
+                // counter saturated, the main loop is woken either way
+            }
+        } else {
+            std::cerr << "Keeping the current configuration" << std::endl;
+        }
+        busy = false;
+        // A request that raced with the end of the parse is picked up here,
+        // unless it already claimed busy and starts a worker of its own
+    } while (again && !busy.exchange(true));
+}
+
+gebaar::config::Loader::~Loader()
+{
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (event_fd >= 0) {
+        close(event_fd);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_CONFIG_LOADER_H
+#define GEBAAR_CONFIG_LOADER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "config.h"
+
+namespace gebaar::config {
+    /**
+     * Parses configuration files on a worker thread. A finished snapshot is
+     * published atomically and announced on an eventfd, so the main loop
+     * only ever swaps a pointer and never waits on the parser.
+     */
+    class Loader {
+    public:
+        ~Loader();
+
+        bool initialize();
+
+        int get_fd() const { return event_fd; }
+
+        void request(const std::string& path);
+
+        std::shared_ptr<const Config> take();
+
+    private:
+        int event_fd = -1;
+        std::thread worker;
+        std::atomic<bool> busy{false};
+        std::atomic<bool> again{false};
+        std::string requested_path;
+        std::shared_ptr<const Config> pending;
+
+        void work();
+    };
+}
+
+#endif //GEBAAR_CONFIG_LOADER_H
@@ -0,0 +1,179 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <map>
+#include "sequences.h"
+
+/**
+ * Create an empty table, a DFA with only the start state
+ */
+gebaar::config::SequenceTable::SequenceTable()
+        :commands(1),
+         tokens(gebaar::gesture::GESTURE_TYPE_COUNT * BINDING_MAX_FINGERS * BINDING_DIRECTIONS, 0),
+         transitions(1, 0),
+         accepts(1, {0, 0}),
+         trie(1)
+{
+}
+
+/**
+ * Add a sequence binding, compile() has to be called once all are added
+ *
+ * @param steps gestures in order, every step a chord of one or more gestures
+ * @param command command to run once the sequence is complete
+ * @return false if the sequence is empty, invalid or too large
+ */
+bool gebaar::config::SequenceTable::add(const std::vector<std::vector<sequence_gesture>>& steps,
+                                        gebaar::action::Command command)
+{
+    if (steps.empty() || command.empty()) {
+        return false;
+    }
+    // Every order a chord can be played in is a path of its own
+    std::vector<std::vector<uint16_t>> paths(1);
+    for (const auto& step : steps) {
+        if (step.empty() || step.size() > CHORD_MAX_GESTURES) {
+            return false;
+        }
+        std::vector<uint16_t> chord;
+        for (const auto& gesture : step) {
+            if (gesture.fingers < 0 || gesture.fingers >= BINDING_MAX_FINGERS || gesture.direction < 0
+                || gesture.direction >= BINDING_DIRECTIONS) {
+                return false;
+            }
+            chord.push_back(token_of(gesture));
+        }
+        std::sort(chord.begin(), chord.end());
+        std::vector<std::vector<uint16_t>> extended;
+        do {
+            for (const auto& path : paths) {
+                extended.push_back(path);
+                extended.back().insert(extended.back().end(), chord.begin(), chord.end());
+            }
+        } while (std::next_permutation(chord.begin(), chord.end()));
+        paths = std::move(extended);
+        if (paths.size() > SEQUENCE_MAX_STATES) {
+            return false;
+        }
+    }
+    if (command.is_native()) {
+        ++native_commands;
+    }
+    commands.push_back(std::move(command));
+    for (const auto& path : paths) {
+        insert(path, static_cast<uint16_t>(commands.size() - 1));
+    }
+    return true;
+}
+
+/**
+ * Token of a gesture, handing out a new one the first time it is seen
+ *
+ * @param gesture gesture of a sequence
+ * @return token, never 0
+ */
+uint16_t gebaar::config::SequenceTable::token_of(const sequence_gesture& gesture)
+{
+    uint16_t& token = tokens[index(gesture.type, gesture.fingers, gesture.direction)];
+    if (token == 0) {
+        token = static_cast<uint16_t>(token_count++);
+    }
+    return token;
+}
+
+/**
+ * Add one path of tokens to the trie of all sequences, a path that was
+ * added before runs the newer command
+ *
+ * @param path tokens in order
+ * @param command command handle
+ */
+void gebaar::config::SequenceTable::insert(const std::vector<uint16_t>& path, uint16_t command)
+{
+    size_t node = 0;
+    for (uint16_t token : path) {
+        auto& children = trie[node].children;
+        auto child = std::find_if(children.begin(), children.end(),
+                                  [token](const std::pair<uint16_t, size_t>& entry) { return entry.first == token; });
+        if (child != children.end()) {
+            node = child->second;
+            continue;
+        }
+        size_t depth = trie[node].depth + 1;
+        children.emplace_back(token, trie.size());
+        node = trie.size();
+        trie.emplace_back();
+        trie[node].depth = depth;
+    }
+    trie[node].command = command;
+}
+
+/**
+ * Turn the trie into a DFA by subset construction. A DFA state is the set
+ * of trie nodes the gestures so far could have reached, always including
+ * the root so a sequence can start at any gesture. A state runs the command
+ * of the longest sequence it completes. A completed sequence consumes its
+ * gestures, unless a longer one continues from it
+ *
+ * @return false if the DFA grew beyond SEQUENCE_MAX_STATES
+ */
+bool gebaar::config::SequenceTable::compile()
+{
+    std::vector<std::vector<size_t>> states = {{0}};
+    std::map<std::vector<size_t>, uint16_t> ids = {{{0}, 0}};
+    transitions.clear();
+    accepts.clear();
+    for (size_t state = 0; state < states.size(); ++state) {
+        const std::vector<size_t> nodes = states[state];
+        for (size_t token = 0; token < token_count; ++token) {
+            std::vector<size_t> target = {0};
+            for (size_t node : nodes) {
+                for (const auto& child : trie[node].children) {
+                    if (child.first == token) {
+                        target.push_back(child.second);
+                    }
+                }
+            }
+            std::sort(target.begin(), target.end());
+            auto id = ids.find(target);
+            if (id == ids.end()) {
+                if (states.size() >= SEQUENCE_MAX_STATES) {
+                    return false;
+                }
+                id = ids.emplace(target, static_cast<uint16_t>(states.size())).first;
+                states.push_back(target);
+            }
+            transitions.push_back(id->second);
+        }
+
+        const trie_node* completed = nullptr;
+        for (size_t node : nodes) {
+            if (trie[node].command != 0 && (completed == nullptr || trie[node].depth > completed->depth)) {
+                completed = &trie[node];
+            }
+        }
+        if (completed == nullptr) {
+            accepts.push_back({0, static_cast<uint16_t>(state)});
+        } else {
+            accepts.push_back({completed->command, completed->children.empty() ? start()
+                                                                               : static_cast<uint16_t>(state)});
+        }
+    }
+    return true;
+}
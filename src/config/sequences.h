@@ -0,0 +1,104 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_SEQUENCES_H
+#define GEBAAR_SEQUENCES_H
+
+#include <cstdint>
+#include <vector>
+#include "../action/command.h"
+#include "../gesture/event.h"
+#include "bindings.h"
+
+#define SEQUENCE_MAX_STATES     1024
+#define CHORD_MAX_GESTURES      3
+
+namespace gebaar::config {
+    struct sequence_gesture {
+        gebaar::gesture::gesture_type type;
+        int fingers;
+        int direction;
+    };
+
+    /**
+     * Sequence bindings ("swipe up, then down") compiled into a DFA over
+     * recognized gestures. Every gesture that appears in a sequence is a
+     * token, all others share token 0, and the DFA runs every sequence at
+     * once: following a gesture is one indexed load, no matter how many
+     * sequences are bound. A step can be a chord, gestures that may come in
+     * any order, which compiles into one path per order. Timing out is not
+     * part of the table, it always goes back to the start state.
+     */
+    class SequenceTable {
+    public:
+        SequenceTable();
+
+        bool add(const std::vector<std::vector<sequence_gesture>>& steps, gebaar::action::Command command);
+
+        bool compile();
+
+        bool empty() const { return commands.size() == 1; }
+
+        bool uses_native() const { return native_commands > 0; }
+
+        static uint16_t start() { return 0; }
+
+        uint16_t next(uint16_t state, gebaar::gesture::gesture_type type, int fingers, int direction) const
+        {
+            if (fingers < 0 || fingers >= BINDING_MAX_FINGERS || direction < 0 || direction >= BINDING_DIRECTIONS) {
+                return start();
+            }
+            return transitions[state * token_count + tokens[index(type, fingers, direction)]];
+        }
+
+        const gebaar::action::Command& command(uint16_t state) const { return commands[accepts[state].command]; }
+
+        uint16_t resume(uint16_t state) const { return accepts[state].resume; }
+
+    private:
+        struct trie_node {
+            std::vector<std::pair<uint16_t, size_t>> children;
+            size_t depth = 0;
+            uint16_t command = 0;
+        };
+
+        struct accept {
+            uint16_t command;
+            uint16_t resume;        // state after running the command
+        };
+
+        std::vector<gebaar::action::Command> commands;
+        std::vector<uint16_t> tokens;
+        size_t token_count = 1;
+        size_t native_commands = 0;
+        std::vector<uint16_t> transitions;
+        std::vector<accept> accepts;
+        std::vector<trie_node> trie;
+
+        void insert(const std::vector<uint16_t>& path, uint16_t command);
+
+        uint16_t token_of(const sequence_gesture& gesture);
+
+        static size_t index(gebaar::gesture::gesture_type type, int fingers, int direction)
+        {
+            return (static_cast<size_t>(type) * BINDING_MAX_FINGERS + fingers) * BINDING_DIRECTIONS + direction;
+        }
+    };
+}
+
+#endif //GEBAAR_SEQUENCES_H
@@ -0,0 +1,139 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_GESTURE_EVENT_H
+#define GEBAAR_GESTURE_EVENT_H
+
+#include <cstdint>
+
+#define GESTURE_MAX_DEVICES     16
+
+namespace gebaar::gesture {
+    enum event_type {
+        EVENT_SWIPE_BEGIN,
+        EVENT_SWIPE_UPDATE,
+        EVENT_SWIPE_END,
+        EVENT_PINCH_BEGIN,
+        EVENT_PINCH_UPDATE,
+        EVENT_PINCH_END,
+        EVENT_HOLD_BEGIN,
+        EVENT_HOLD_END,
+        EVENT_TOUCH_DOWN,
+        EVENT_TOUCH_MOTION,
+        EVENT_TOUCH_UP,
+        EVENT_TOUCH_CANCEL,
+    };
+
+    /*
+     * Touchpad swipes, pinches and holds, and touchscreen taps and edge
+     * swipes recognized from the raw touch stream
+     */
+    enum gesture_type {GESTURE_SWIPE, GESTURE_PINCH, GESTURE_HOLD, GESTURE_TOUCH, GESTURE_TYPE_COUNT};
+
+    enum modifier {
+        MODIFIER_SHIFT = 1 << 0,
+        MODIFIER_CTRL = 1 << 1,
+        MODIFIER_ALT = 1 << 2,
+        MODIFIER_SUPER = 1 << 3,
+        MODIFIER_COMBINATIONS = 1 << 4,
+    };
+
+    /*
+     * Backend independent gesture event, what an event source hands to the
+     * recognizer
+     */
+    struct gesture_event {
+        event_type type;
+        int fingers;
+        double dx;              // unaccelerated
+        double dy;              // unaccelerated
+        double scale;
+        double angle;           // angle delta
+        bool cancelled;
+        unsigned int modifiers; // keyboard modifiers held, see modifier
+        unsigned int device;    // device slot, below GESTURE_MAX_DEVICES
+        int slot;               // touch slot of touch events
+        double x;               // touch position, 0-1 across the screen
+        double y;
+        uint64_t time_usec;     // CLOCK_MONOTONIC
+    };
+
+    /*
+     * A gesture the recognizer decided on, direction is the swipe_type of
+     * the swipe (1-9) or Config::pinch for pinches. Swipes tell how far they
+     * went, pinches their scale and rotation so far
+     */
+    struct recognized_gesture {
+        gesture_type type;
+        int fingers;
+        int direction;
+        unsigned int modifiers;
+        unsigned int device;
+        uint64_t time_usec;
+        double dx;              // mm
+        double dy;
+        double scale;
+        double angle;           // degrees, clockwise positive
+    };
+
+    enum progress_phase {PROGRESS_BEGIN, PROGRESS_UPDATE, PROGRESS_END};
+
+    /*
+     * Where a gesture in progress stands, for animating along with it.
+     * progress is the swipe distance in threshold steps, or for pinches the
+     * scale change in threshold steps (negative when pinching in)
+     */
+    struct gesture_progress {
+        gesture_type type;
+        progress_phase phase;
+        int fingers;
+        unsigned int device;
+        double progress;
+        double dx;              // mm moved since the gesture began
+        double dy;              // mm moved since the gesture began
+        double scale;
+        double angle;           // degrees rotated since the gesture began
+        bool cancelled;
+        uint64_t time_usec;
+    };
+
+    inline gesture_type gesture_of(event_type type)
+    {
+        if (type < EVENT_PINCH_BEGIN) {
+            return GESTURE_SWIPE;
+        }
+        if (type < EVENT_HOLD_BEGIN) {
+            return GESTURE_PINCH;
+        }
+        return type < EVENT_TOUCH_DOWN ? GESTURE_HOLD : GESTURE_TOUCH;
+    }
+
+    inline bool ends_gesture(event_type type)
+    {
+        return type == EVENT_SWIPE_END || type == EVENT_PINCH_END || type == EVENT_HOLD_END
+               || type == EVENT_TOUCH_UP || type == EVENT_TOUCH_CANCEL;
+    }
+
+    inline const char* gesture_name(gesture_type type)
+    {
+        static const char* const names[GESTURE_TYPE_COUNT] = {"swipe", "pinch", "hold", "touch"};
+        return names[type];
+    }
+}
+
+#endif //GEBAAR_GESTURE_EVENT_H
@@ -0,0 +1,642 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "recognizer.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Recognizer constructor
+ *
+ * @param config_ptr shared pointer to configuration object
+ * @param on_gesture called for every recognized gesture
+ */
+gebaar::gesture::Recognizer::Recognizer(
+    std::shared_ptr<const gebaar::config::Config> const &config_ptr,
+    listener on_gesture)
+    : config(config_ptr), on_gesture(std::move(on_gesture)) {
+  for (auto &state : devices) {
+    state.config = config;
+    state.swipe = {};
+    state.pinch = {};
+    state.pinch.scale = DEFAULT_SCALE;
+    state.hold = {};
+    state.touch = {};
+    resolve_device(state);
+  }
+}
+
+/**
+ * Switch to a new configuration snapshot. A gesture in progress finishes
+ * with the settings it started with, every device adopts the snapshot when
+ * its next gesture begins
+ * @param config_ptr new configuration snapshot
+ */
+void gebaar::gesture::Recognizer::set_config(
+    std::shared_ptr<const gebaar::config::Config> const &config_ptr) {
+  config = config_ptr;
+}
+
+/**
+ * A device took a slot, look up its thresholds and scaling
+ * @param slot device slot
+ * @param name device name
+ * @param width touchpad width in mm, 0 if unknown
+ * @param height touchpad height in mm, 0 if unknown
+ */
+void gebaar::gesture::Recognizer::add_device(unsigned int slot,
+                                             const std::string &name,
+                                             double width, double height) {
+  if (slot >= GESTURE_MAX_DEVICES) {
+    return;
+  }
+  devices[slot].name = name;
+  devices[slot].width = width;
+  devices[slot].height = height;
+  devices[slot].config = config;
+  resolve_device(devices[slot]);
+}
+
+/**
+ * Work out the swipe distance of one step on a device, once per device and
+ * configuration instead of on every event. Deltas are normalized to
+ * 1000dpi, so millimetres and fractions of the pad convert the same way on
+ * every touchpad. A fraction needs the pad size and falls back to the
+ * unitless threshold without it
+ * @param state device state to update
+ */
+void gebaar::gesture::Recognizer::resolve_device(device_state &state) {
+  state.settings = state.config->settings_for_device(state.name);
+  const auto &settings = state.settings;
+  if (settings.swipe_threshold_mm > 0) {
+    state.swipe_x = settings.swipe_threshold_mm * SWIPE_UNITS_PER_MM;
+    state.swipe_y = state.swipe_x;
+  } else if (settings.swipe_threshold_fraction > 0 && state.width > 0 &&
+             state.height > 0) {
+    state.swipe_x =
+        settings.swipe_threshold_fraction * state.width * SWIPE_UNITS_PER_MM;
+    state.swipe_y =
+        settings.swipe_threshold_fraction * state.height * SWIPE_UNITS_PER_MM;
+  } else {
+    state.swipe_x = settings.swipe_threshold * SWIPE_X_THRESHOLD;
+    state.swipe_y = settings.swipe_threshold * SWIPE_Y_THRESHOLD;
+  }
+}
+
+/**
+ * The device in a slot went away, drop whatever gesture it was making
+ * @param slot device slot
+ */
+void gebaar::gesture::Recognizer::remove_device(unsigned int slot) {
+  if (slot >= GESTURE_MAX_DEVICES) {
+    return;
+  }
+  device = &devices[slot];
+  reset_swipe_event();
+  reset_pinch_event();
+  device->hold = {};
+  device->touch = {};
+  device->name.clear();
+  device->width = 0;
+  device->height = 0;
+  device->config = config;
+  resolve_device(*device);
+}
+
+/**
+ * Feed one gesture event into the state machines
+ * @param event gesture event
+ */
+void gebaar::gesture::Recognizer::handle(const gesture_event &event) {
+  time_usec = event.time_usec;
+  modifiers = event.modifiers;
+  device = &devices[event.device < GESTURE_MAX_DEVICES ? event.device : 0];
+  // Only a gesture starting on this device adopts a new snapshot, the
+  // gestures on other devices keep theirs. On a touchscreen that is the
+  // first finger down
+  if (device->config != config &&
+      (event.type == EVENT_SWIPE_BEGIN || event.type == EVENT_PINCH_BEGIN ||
+       event.type == EVENT_HOLD_BEGIN ||
+       (event.type == EVENT_TOUCH_DOWN && device->touch.active == 0))) {
+    device->config = config;
+    resolve_device(*device);
+  }
+  // The end of a gesture resets its state, report where it ended first.
+  // Only swipes and pinches have a progress
+  bool progress = on_progress && gesture_of(event.type) <= GESTURE_PINCH;
+  bool end = ends_gesture(event.type);
+  if (progress && end) {
+    report_progress(event);
+  }
+  switch (event.type) {
+  case EVENT_SWIPE_BEGIN:
+    handle_swipe_event_without_coords(event, true);
+    break;
+  case EVENT_SWIPE_UPDATE:
+    handle_swipe_event_with_coords(event);
+    break;
+  case EVENT_SWIPE_END:
+    handle_swipe_event_without_coords(event, false);
+    break;
+  case EVENT_PINCH_BEGIN:
+    handle_pinch_event(event, true);
+    break;
+  case EVENT_PINCH_UPDATE:
+    handle_pinch_event(event, false);
+    break;
+  case EVENT_PINCH_END:
+    handle_pinch_event(event, false);
+    break;
+  case EVENT_HOLD_BEGIN:
+    handle_hold_event(event, true);
+    break;
+  case EVENT_HOLD_END:
+    handle_hold_event(event, false);
+    break;
+  case EVENT_TOUCH_DOWN:
+  case EVENT_TOUCH_MOTION:
+  case EVENT_TOUCH_UP:
+  case EVENT_TOUCH_CANCEL:
+    handle_touch_event(event);
+    break;
+  }
+  if (progress && !end) {
+    report_progress(event);
+  }
+}
+
+/**
+ * Report a recognized gesture to the listener
+ * @param type kind of gesture
+ * @param fingers finger count
+ * @param direction swipe_type or pinch direction
+ */
+void gebaar::gesture::Recognizer::emit(gesture_type type, int fingers,
+                                       int direction) {
+  recognized_gesture gesture{type, fingers, direction, modifiers,
+                             static_cast<unsigned int>(device - devices),
+                             time_usec, 0, 0, DEFAULT_SCALE, 0};
+  if (type == GESTURE_SWIPE) {
+    gesture.dx = device->swipe.x / SWIPE_UNITS_PER_MM;
+    gesture.dy = device->swipe.y / SWIPE_UNITS_PER_MM;
+  } else if (type == GESTURE_PINCH) {
+    gesture.scale = device->pinch.scale;
+    gesture.angle = device->pinch.angle;
+  }
+  on_gesture(gesture);
+}
+
+/**
+ * Tell the progress listener where the gesture of the current device stands
+ * @param event gesture event that moved it
+ */
+void gebaar::gesture::Recognizer::report_progress(const gesture_event &event) {
+  gesture_progress progress{};
+  progress.type = gesture_of(event.type);
+  progress.phase = event.type == EVENT_SWIPE_BEGIN ||
+                           event.type == EVENT_PINCH_BEGIN
+                       ? PROGRESS_BEGIN
+                   : event.type == EVENT_SWIPE_END ||
+                           event.type == EVENT_PINCH_END
+                       ? PROGRESS_END
+                       : PROGRESS_UPDATE;
+  progress.device = static_cast<unsigned int>(device - devices);
+  progress.cancelled = event.cancelled;
+  progress.time_usec = event.time_usec;
+  if (progress.type == GESTURE_SWIPE) {
+    progress.fingers = device->swipe.fingers;
+    progress.progress = std::max(std::abs(device->swipe.x) / device->swipe_x,
+                                 std::abs(device->swipe.y) / device->swipe_y);
+    progress.dx = device->swipe.x / SWIPE_UNITS_PER_MM;
+    progress.dy = device->swipe.y / SWIPE_UNITS_PER_MM;
+    progress.scale = DEFAULT_SCALE;
+  } else {
+    progress.fingers = device->pinch.fingers;
+    progress.progress = (device->pinch.scale - DEFAULT_SCALE) /
+                        device->settings.pinch_threshold;
+    progress.scale = device->pinch.scale;
+    progress.angle = device->pinch.angle;
+  }
+  on_progress(progress);
+}
+
+/**
+ * Reset swipe event struct to defaults
+ */
+void gebaar::gesture::Recognizer::reset_swipe_event() {
+  device->swipe = {};
+  device->swipe.executed = false;
+  device->swipe.step = 1;
+}
+
+/**
+ * Reset pinch event struct to defaults
+ */
+void gebaar::gesture::Recognizer::reset_pinch_event() {
+  device->pinch = {};
+  device->pinch.scale = DEFAULT_SCALE;
+  device->pinch.executed = false;
+}
+
+/**
+ * Pinch one_shot gesture handle
+ * @param new_scale last reported scale between the fingers
+ */
+void gebaar::gesture::Recognizer::handle_one_shot_pinch(double new_scale) {
+  if (new_scale > device->pinch.scale) { // Scale up
+    // Add 1 to required distance to get 2 > x > 1
+    if (new_scale > 1 + device->settings.pinch_threshold) {
+      emit(GESTURE_PINCH, device->pinch.fingers, device->config->PINCH_IN);
+      device->pinch.executed = true;
+    }
+  } else { // Scale Down
+    // Substract from 1 to have inverted value for pinch in gesture
+    if (device->pinch.scale < 1 - device->settings.pinch_threshold) {
+      emit(GESTURE_PINCH, device->pinch.fingers, device->config->PINCH_OUT);
+      device->pinch.executed = true;
+    }
+  }
+}
+
+/**
+ * Pinch continous gesture handle
+ * Calculates the trigger value according to current step
+ * @param new_scale last reported scale between the fingers
+ */
+void gebaar::gesture::Recognizer::handle_continouos_pinch(double new_scale) {
+  int step = device->pinch.step == 0 ? device->pinch.step + 1
+                                           : device->pinch.step;
+  double trigger = 1 + (device->settings.pinch_threshold * step);
+
+  if (new_scale > device->pinch.scale) { // Scale up
+    if (new_scale >= trigger) {
+      emit(GESTURE_PINCH, device->pinch.fingers, device->config->PINCH_IN);
+      inc_step(device->pinch.step);
+    }
+  } else { // Scale down
+    if (new_scale <= trigger) {
+      emit(GESTURE_PINCH, device->pinch.fingers, device->config->PINCH_OUT);
+      dec_step(device->pinch.step);
+    }
+  }
+}
+
+/**
+ * Pinch Gesture
+ * Zooms in and out and rotates, each one shot or stepped.
+ * @param event Gesture Event
+ * @param begin Boolean to denote begin or continuation of gesture.
+ **/
+void gebaar::gesture::Recognizer::handle_pinch_event(
+    const gesture_event &event, bool begin) {
+  if (begin) {
+    reset_pinch_event();
+    device->pinch.fingers = event.fingers;
+  } else {
+    double new_scale = event.scale;
+    device->pinch.angle += event.angle;
+    classify_pinch(new_scale);
+    if (device->pinch.kind & PINCH_KIND_PINCH) {
+      if (device->config->settings.pinch_one_shot && !device->pinch.executed)
+        handle_one_shot_pinch(new_scale);
+      if (!device->config->settings.pinch_one_shot)
+        handle_continouos_pinch(new_scale);
+    }
+    if (device->pinch.kind & PINCH_KIND_ROTATE) {
+      handle_rotation();
+    }
+    device->pinch.scale = new_scale;
+  }
+}
+
+/**
+ * Decide whether a pinch gesture zooms, rotates or does both, once either
+ * motion got halfway to its threshold. Both are compared in thresholds, a
+ * motion counts if it is at least half as strong as the other. Without
+ * rotate bindings every pinch is a plain pinch right away
+ * @param new_scale last reported scale between the fingers
+ */
+void gebaar::gesture::Recognizer::classify_pinch(double new_scale) {
+  if (device->pinch.kind != PINCH_UNDECIDED) {
+    return;
+  }
+  if (!device->config->settings.pinch_rotate) {
+    device->pinch.kind = PINCH_KIND_PINCH;
+    return;
+  }
+  double zoom = std::abs(new_scale - DEFAULT_SCALE) /
+                device->settings.pinch_threshold;
+  double rotation =
+      std::abs(device->pinch.angle) / device->config->settings.rotate_threshold;
+  if (std::max(zoom, rotation) < PINCH_CLASSIFY_AT) {
+    return;
+  }
+  if (zoom >= rotation * PINCH_BOTH_RATIO) {
+    device->pinch.kind |= PINCH_KIND_PINCH;
+  }
+  if (rotation >= zoom * PINCH_BOTH_RATIO) {
+    device->pinch.kind |= PINCH_KIND_ROTATE;
+  }
+}
+
+/**
+ * Report a rotate step for every rotate threshold the fingers turned, or
+ * once per gesture in one shot mode
+ */
+void gebaar::gesture::Recognizer::handle_rotation() {
+  auto &pinch = device->pinch;
+  int steps = static_cast<int>(pinch.angle /
+                               device->config->settings.rotate_threshold);
+  if (device->config->settings.rotate_one_shot) {
+    if (!pinch.rotate_executed && steps != 0) {
+      emit(GESTURE_PINCH, pinch.fingers,
+           steps > 0 ? device->config->ROTATE_CW : device->config->ROTATE_CCW);
+      pinch.rotate_executed = true;
+    }
+    return;
+  }
+  for (; pinch.rotate_steps < steps; ++pinch.rotate_steps) {
+    emit(GESTURE_PINCH, pinch.fingers, device->config->ROTATE_CW);
+  }
+  for (; pinch.rotate_steps > steps; --pinch.rotate_steps) {
+    emit(GESTURE_PINCH, pinch.fingers, device->config->ROTATE_CCW);
+  }
+}
+
+/**
+ * This event has no coordinates, so it's an event that gives us a begin or end
+ * signal. If it begins, we get the amount of fingers used. If it ends, we check
+ * what kind of gesture we received.
+ *
+ * @param event Gesture Event
+ * @param begin Boolean to denote begin or end of gesture
+ */
+void gebaar::gesture::Recognizer::handle_swipe_event_without_coords(
+    const gesture_event &event, bool begin) {
+  if (begin) {
+    reset_swipe_event();
+    device->swipe.fingers = event.fingers;
+  }
+  // This executed when fingers left the touchpad
+  else {
+    if (!device->swipe.executed &&
+        device->config->settings.swipe_trigger_on_release) {
+      trigger_swipe_command();
+    }
+    reset_swipe_event();
+  }
+}
+
+/**
+ * Swipe events with coordinates, add it to the current tally
+ * @param event Gesture Event
+ */
+void gebaar::gesture::Recognizer::handle_swipe_event_with_coords(
+    const gesture_event &event) {
+  if (device->config->settings.swipe_one_shot && device->swipe.executed)
+    return;
+
+  int threshold_x = device->swipe_x * device->swipe.step;
+  int threshold_y = device->swipe_y * device->swipe.step;
+  double dx = event.dx * device->settings.scale;
+  double dy = event.dy * device->settings.scale;
+  device->swipe.x += dx;
+  device->swipe.y += dy;
+  record_swipe_sample(dx, dy, event.time_usec);
+  if (std::abs(device->swipe.x) > threshold_x ||
+      std::abs(device->swipe.y) > threshold_y ||
+      (device->config->settings.swipe_early_recognition &&
+       !device->swipe.executed && swipe_is_confident())) {
+    trigger_swipe_command();
+    device->swipe.executed = true;
+    inc_step(device->swipe.step);
+  }
+}
+
+/**
+ * Remember the latest swipe delta in the ring buffer of the gesture
+ * @param dx scaled horizontal delta
+ * @param dy scaled vertical delta
+ * @param time_usec event time
+ */
+void gebaar::gesture::Recognizer::record_swipe_sample(double dx, double dy,
+                                                      uint64_t time_usec) {
+  auto &sample =
+      device->swipe.samples[device->swipe.sample_count % SWIPE_SAMPLES];
+  sample = {dx, dy, time_usec};
+  ++device->swipe.sample_count;
+}
+
+/**
+ * Decide whether a swipe that has not reached its threshold yet is a
+ * deliberate flick. It is if the recent motion is fast enough, points the
+ * same way as the whole swipe so far and is not braking to a halt, and the
+ * swipe has covered a minimum share of the threshold already
+ * @return bool
+ */
+bool gebaar::gesture::Recognizer::swipe_is_confident() const {
+  const auto &swipe = device->swipe;
+  unsigned int count = std::min(swipe.sample_count, SWIPE_SAMPLES);
+  if (count < SWIPE_EARLY_MIN_SAMPLES ||
+      (std::abs(swipe.x) < device->swipe_x * SWIPE_EARLY_MIN_DISTANCE &&
+       std::abs(swipe.y) < device->swipe_y * SWIPE_EARLY_MIN_DISTANCE)) {
+    return false;
+  }
+
+  // Oldest sample first, its delta happened before the window began
+  unsigned int first = swipe.sample_count - count;
+  unsigned int middle = first + count / 2;
+  double old_x = 0, old_y = 0, new_x = 0, new_y = 0;
+  for (unsigned int i = first + 1; i < swipe.sample_count; ++i) {
+    const auto &sample = swipe.samples[i % SWIPE_SAMPLES];
+    (i <= middle ? old_x : new_x) += sample.dx;
+    (i <= middle ? old_y : new_y) += sample.dy;
+  }
+  auto time_of = [&swipe](unsigned int i) {
+    return swipe.samples[i % SWIPE_SAMPLES].time_usec;
+  };
+  uint64_t old_time = time_of(middle) - time_of(first);
+  uint64_t new_time = time_of(swipe.sample_count - 1) - time_of(middle);
+  if (old_time == 0 || new_time == 0) {
+    return false;
+  }
+
+  // Speeds in mm/s, deltas are normalized to 1000dpi
+  double to_mm_per_sec = 1000000.0 / SWIPE_UNITS_PER_MM;
+  double old_speed = std::hypot(old_x, old_y) / old_time * to_mm_per_sec;
+  double new_speed = std::hypot(new_x, new_y) / new_time * to_mm_per_sec;
+  double speed = std::hypot(old_x + new_x, old_y + new_y) /
+                 (old_time + new_time) * to_mm_per_sec;
+  return speed >= device->config->settings.swipe_early_velocity &&
+         new_speed >= old_speed * SWIPE_EARLY_MIN_DECELERATION &&
+         swipe_direction(old_x + new_x, old_y + new_y) ==
+             swipe_direction(swipe.x, swipe.y);
+}
+
+/**
+ * Making calculation for swipe direction and reporting the gesture
+ * accordingly
+ */
+void gebaar::gesture::Recognizer::trigger_swipe_command() {
+  emit(GESTURE_SWIPE, device->swipe.fingers,
+       swipe_direction(device->swipe.x, device->swipe.y));
+}
+
+/**
+ * Direction of a motion
+ * @param x horizontal distance
+ * @param y vertical distance
+ * @return swipe_type
+ */
+int gebaar::gesture::Recognizer::swipe_direction(double x, double y) {
+  int swipe_type = 5;                 // middle = no swipe
+                                      // 1 = left_up, 2 = up, 3 = right_up...
+                                      // 1 2 3
+                                      // 4 5 6
+                                      // 7 8 9
+  const double OBLIQUE_RATIO = 0.414; // =~ tan(22.5);
+
+  if (std::abs(x) > std::abs(y)) {
+    // left or right swipe
+    swipe_type += x < 0 ? -1 : 1;
+
+    // check for oblique swipe
+    if (std::abs(y) / std::abs(x) > OBLIQUE_RATIO) {
+      swipe_type += y < 0 ? -3 : 3;
+    }
+  } else {
+    // up of down swipe
+    swipe_type += y < 0 ? -3 : 3;
+
+    // check for oblique swipe
+    if (std::abs(x) / std::abs(y) > OBLIQUE_RATIO) {
+      swipe_type += x < 0 ? -1 : 1;
+    }
+  }
+
+  return swipe_type;
+}
+
+/**
+ * Hold gesture, fingers resting on the touchpad. libinput cancels a hold
+ * that turns into a swipe or pinch, one that lasted long enough and ended
+ * by lifting the fingers is reported
+ * @param event Gesture Event
+ * @param begin Boolean to denote begin or end of gesture
+ */
+void gebaar::gesture::Recognizer::handle_hold_event(const gesture_event &event,
+                                                    bool begin) {
+  auto &hold = device->hold;
+  if (begin) {
+    hold = {event.fingers, event.time_usec, true};
+    return;
+  }
+  if (hold.active && !event.cancelled &&
+      event.time_usec - hold.start_usec >=
+          device->config->settings.hold_duration * 1000ull) {
+    emit(GESTURE_HOLD, hold.fingers, device->config->HOLD);
+  }
+  hold.active = false;
+}
+
+/**
+ * Touchscreen taps and edge swipes, tracked per touch slot. A tap is any
+ * number of touches that all come and go within the tap timeout without
+ * moving, it counts the most fingers down at once. An edge swipe is a
+ * touch that starts at a screen edge and moves inwards
+ * @param event Gesture Event
+ */
+void gebaar::gesture::Recognizer::handle_touch_event(
+    const gesture_event &event) {
+  auto &touch = device->touch;
+  if (event.type == EVENT_TOUCH_CANCEL) {
+    touch = {};
+    return;
+  }
+  if (event.slot < 0 || event.slot >= TOUCH_MAX_SLOTS) {
+    return;
+  }
+  auto &point = touch.points[event.slot];
+  switch (event.type) {
+  case EVENT_TOUCH_DOWN:
+    if (touch.active == 0) {
+      touch = {};
+      touch.start_usec = event.time_usec;
+    }
+    if (!point.down) {
+      ++touch.active;
+      touch.max_fingers = std::max(touch.max_fingers, touch.active);
+    }
+    point = {true, event.x, event.y};
+    break;
+  case EVENT_TOUCH_MOTION:
+    if (!point.down) {
+      return;
+    }
+    if (std::abs(event.x - point.start_x) >
+            device->config->settings.tap_distance ||
+        std::abs(event.y - point.start_y) >
+            device->config->settings.tap_distance) {
+      touch.moved = true;
+    }
+    if (!touch.edge_executed) {
+      handle_edge_swipe(point, event.x, event.y);
+    }
+    break;
+  case EVENT_TOUCH_UP:
+    if (!point.down) {
+      return;
+    }
+    point.down = false;
+    if (--touch.active == 0 && !touch.moved &&
+        event.time_usec - touch.start_usec <=
+            device->config->settings.tap_timeout * 1000ull) {
+      emit(GESTURE_TOUCH, touch.max_fingers, device->config->TOUCH_TAP);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * Report an edge swipe once a touch that started in the zone along an edge
+ * moved far enough away from it
+ * @param point touch that moved
+ * @param x current position, 0-1 across the screen
+ * @param y current position, 0-1 across the screen
+ */
+void gebaar::gesture::Recognizer::handle_edge_swipe(const touch_point &point,
+                                                    double x, double y) {
+  double zone = device->config->settings.edge_zone;
+  double distance = device->config->settings.edge_distance;
+  int edge = -1;
+  if (point.start_x <= zone && x - point.start_x >= distance) {
+    edge = device->config->TOUCH_LEFT_EDGE;
+  } else if (point.start_x >= 1 - zone && point.start_x - x >= distance) {
+    edge = device->config->TOUCH_RIGHT_EDGE;
+  } else if (point.start_y <= zone && y - point.start_y >= distance) {
+    edge = device->config->TOUCH_TOP_EDGE;
+  } else if (point.start_y >= 1 - zone && point.start_y - y >= distance) {
+    edge = device->config->TOUCH_BOTTOM_EDGE;
+  }
+  if (edge >= 0) {
+    emit(GESTURE_TOUCH, device->touch.active, edge);
+    device->touch.edge_executed = true;
+  }
+}
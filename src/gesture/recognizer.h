@@ -0,0 +1,196 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_RECOGNIZER_H
+#define GEBAAR_RECOGNIZER_H
+
+#include <functional>
+#include <string>
+#include "../config/config.h"
+#include "event.h"
+
+#define DEFAULT_SCALE                   1.0
+#define SWIPE_X_THRESHOLD               1000
+#define SWIPE_Y_THRESHOLD               500
+#define SWIPE_UNITS_PER_MM              (1000 / 25.4)
+#define SWIPE_SAMPLES                   8u
+#define SWIPE_EARLY_MIN_SAMPLES         3u
+#define SWIPE_EARLY_MIN_DISTANCE        0.25
+#define SWIPE_EARLY_MIN_DECELERATION    0.5
+#define PINCH_CLASSIFY_AT               0.5
+#define PINCH_BOTH_RATIO                0.5
+#define TOUCH_MAX_SLOTS                 10
+
+namespace gebaar::gesture {
+    struct swipe_sample {
+        double dx;
+        double dy;
+        uint64_t time_usec;
+    };
+
+    struct gesture_swipe_event {
+        int fingers;
+        double x;
+        double y;
+
+        bool executed;
+        int step;
+
+        swipe_sample samples[SWIPE_SAMPLES]; // ring buffer of recent deltas
+        unsigned int sample_count;
+    };
+
+    enum pinch_kind {PINCH_UNDECIDED = 0, PINCH_KIND_PINCH = 1, PINCH_KIND_ROTATE = 2};
+
+    struct gesture_pinch_event {
+        int fingers;
+        double scale;
+        double angle;           // degrees, clockwise positive
+
+        bool executed;
+        int step;
+
+        unsigned int kind;      // pinch_kind mask, decided once per gesture
+        bool rotate_executed;
+        int rotate_steps;       // signed, clockwise steps reported so far
+    };
+
+    struct gesture_hold_event {
+        int fingers;
+        uint64_t start_usec;
+        bool active;
+    };
+
+    struct touch_point {
+        bool down;
+        double start_x;         // 0-1 across the screen
+        double start_y;
+    };
+
+    struct gesture_touch_event {
+        touch_point points[TOUCH_MAX_SLOTS];
+        int active;             // touches down
+        int max_fingers;        // most touches down at once
+        uint64_t start_usec;    // first touch down
+        bool moved;             // too much for a tap
+        bool edge_executed;
+    };
+
+    /**
+     * Swipe, pinch, hold and touchscreen state machines. Fed with backend independent gesture
+     * events, reports every gesture it recognizes to a listener and knows
+     * nothing about commands. Every device slot has its own state, so
+     * gestures on several touchpads don't mix.
+     */
+    class Recognizer {
+    public:
+        using listener = std::function<void(const recognized_gesture&)>;
+        using progress_listener = std::function<void(const gesture_progress&)>;
+
+        Recognizer(std::shared_ptr<const gebaar::config::Config> const& config_ptr, listener on_gesture);
+
+        void handle(const gesture_event& event);
+
+        void set_config(std::shared_ptr<const gebaar::config::Config> const& config_ptr);
+
+        void set_progress_listener(progress_listener listener) { on_progress = std::move(listener); }
+
+        void add_device(unsigned int slot, const std::string& name, double width, double height);
+
+        void remove_device(unsigned int slot);
+
+    private:
+        struct device_state {
+            struct gesture_swipe_event swipe;
+            struct gesture_pinch_event pinch;
+            struct gesture_hold_event hold;
+            struct gesture_touch_event touch;
+            std::string name;
+            double width = 0;     // mm, 0 if unknown
+            double height = 0;
+            gebaar::config::Config::device_settings settings;
+            double swipe_x;     // swipe distance of one step
+            double swipe_y;
+            std::shared_ptr<const gebaar::config::Config> config;  // snapshot the current gesture started with
+        };
+
+        std::shared_ptr<const gebaar::config::Config> config;   // newest snapshot
+        listener on_gesture;
+        progress_listener on_progress;
+        uint64_t time_usec = 0;
+        unsigned int modifiers = 0;
+
+        device_state devices[GESTURE_MAX_DEVICES];
+        device_state* device = devices;
+
+        /*
+         * Decrements step of current trigger. Just to skip 0
+         * @param cur current step
+         */
+        inline void dec_step(int &cur) { --cur == 0 ? --cur : cur; }
+
+        /*
+         * Increase step of current trigger. Just to pass -1
+         * @param cur current step
+         */
+        inline void inc_step(int &cur) { ++cur == 0 ? ++cur : cur; }
+
+        void emit(gesture_type type, int fingers, int direction);
+
+        void resolve_device(device_state& state);
+
+        void report_progress(const gesture_event& event);
+
+        /* Swipe event */
+        void reset_swipe_event();
+
+        void handle_swipe_event_without_coords(const gesture_event& event, bool begin);
+
+        void handle_swipe_event_with_coords(const gesture_event& event);
+
+        void record_swipe_sample(double dx, double dy, uint64_t time_usec);
+
+        bool swipe_is_confident() const;
+
+        void trigger_swipe_command();
+
+        static int swipe_direction(double x, double y);
+
+        /* Pinch event */
+        void reset_pinch_event();
+
+        void handle_one_shot_pinch(double new_scale);
+
+        void handle_continouos_pinch(double new_scale);
+
+        void handle_pinch_event(const gesture_event& event, bool begin);
+
+        void classify_pinch(double new_scale);
+
+        void handle_rotation();
+
+        /* Hold and touchscreen events */
+        void handle_hold_event(const gesture_event& event, bool begin);
+
+        void handle_touch_event(const gesture_event& event);
+
+        void handle_edge_swipe(const touch_point& point, double x, double y);
+    };
+}
+
+#endif //GEBAAR_RECOGNIZER_H
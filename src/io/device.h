@@ -0,0 +1,36 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_DEVICE_H
+#define GEBAAR_DEVICE_H
+
+#include <string>
+
+namespace gebaar::io {
+    /*
+     * What an event source knows about one of its devices, looked up once
+     * when the device is added
+     */
+    struct device_info {
+        std::string name;
+        double width;           // mm, 0 if unknown
+        double height;          // mm, 0 if unknown
+    };
+}
+
+#endif //GEBAAR_DEVICE_H
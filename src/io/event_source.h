@@ -0,0 +1,61 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_EVENT_SOURCE_H
+#define GEBAAR_EVENT_SOURCE_H
+
+#include <cstddef>
+#include <functional>
+#include "../gesture/event.h"
+#include "device.h"
+
+namespace gebaar::io {
+    /**
+     * Where gesture events come from. The main loop polls get_fd() and
+     * drains the source with read_events() whenever it becomes readable.
+     * Gesture events name the device slot they came from, the device listener
+     * learns which device occupies a slot.
+     */
+    class EventSource {
+    public:
+        /*
+         * Called with the device when a slot is taken, nullptr when the
+         * device in it went away
+         */
+        using device_listener = std::function<void(unsigned int slot, const device_info* device)>;
+
+        virtual ~EventSource() = default;
+
+        virtual bool initialize() = 0;
+
+        virtual int get_fd() const = 0;
+
+        /*
+         * Fill events with up to max pending gesture events
+         * @return number of events written, 0 once the source is drained
+         */
+        virtual size_t read_events(gebaar::gesture::gesture_event* events, size_t max) = 0;
+
+        void set_device_listener(device_listener listener) { on_device = std::move(listener); }
+
+    protected:
+        device_listener on_device;
+    };
+}
+
+#endif //GEBAAR_EVENT_SOURCE_H
@@ -17,198 +17,339 @@
 */
 
 #include "input.h"
-#include <poll.h>
+#include "../stats/startup.h"
+#include <cmath>
+#include <csignal>
+#include <iomanip>
+#include <sys/epoll.h>
+
+using namespace gebaar::gesture;
 
 /**
  * Input system constructor, we pass our Configuration object via a shared
  * pointer
  *
  * @param config_ptr shared pointer to configuration object
+ * @param source where gesture events come from
+ * @param stats_on_exit print latency statistics when terminated
  */
 gebaar::io::Input::Input(
-    std::shared_ptr<gebaar::config::Config> const &config_ptr) {
-  config = config_ptr;
-  gesture_swipe_event = {};
+    std::shared_ptr<const gebaar::config::Config> const &config_ptr,
+    std::unique_ptr<EventSource> source, bool stats_on_exit)
+    : config(config_ptr), source(std::move(source)),
+      recognizer(config_ptr,
+                 [this](const recognized_gesture &gesture) {
+                   dispatch(gesture);
+                 }),
+      helpers(executor), continuous(uinput), stream(reactor), bus(reactor),
+      stats_on_exit(stats_on_exit) {}
 
-  gesture_pinch_event = {};
-  gesture_pinch_event.scale = DEFAULT_SCALE;
+/**
+ * Tell the bus about a recognized gesture, run the command bound to it and
+ * follow the sequences it belongs to
+ * @param gesture gesture reported by the recognizer
+ */
+void gebaar::io::Input::dispatch(const recognized_gesture &gesture) {
+  if (bus_enabled) {
+    bus.publish(gesture);
+  }
+  run_command(config->bindings.lookup(gesture.type, gesture.fingers,
+                                      gesture.direction, gesture.modifiers),
+              gesture);
+  if (!config->sequences.empty()) {
+    follow_sequences(gesture);
+  }
 }
 
 /**
- * Initialize the libinput context
- *
- * @return bool
+ * Step the sequence DFA and run the command of a completed sequence. A
+ * partial sequence is forgotten once the next gesture takes too long
+ * @param gesture gesture reported by the recognizer
  */
-bool gebaar::io::Input::initialize_context() {
-  udev = udev_new();
-  libinput = libinput_udev_create_context(&libinput_interface, nullptr, udev);
-  return libinput_udev_assign_seat(libinput, "seat0") == 0;
+void gebaar::io::Input::follow_sequences(const recognized_gesture &gesture) {
+  const auto &sequences = config->sequences;
+  sequence_state = sequences.next(sequence_state, gesture.type,
+                                  gesture.fingers, gesture.direction);
+  const auto &command = sequences.command(sequence_state);
+  if (!command.empty()) {
+    run_command(command, gesture);
+    sequence_state = sequences.resume(sequence_state);
+  }
+  if (sequence_timer >= 0) {
+    reactor.arm_timer(sequence_timer,
+                      sequence_state == sequences.start()
+                          ? 0
+                          : config->settings.sequence_timeout * 1000ull);
+  }
 }
 
 /**
- * Reset swipe event struct to defaults
+ * Run a bound command, unless its limits hold it back
+ * @param command pre-parsed command to run
+ * @param gesture gesture the command is bound to
  */
-void gebaar::io::Input::reset_swipe_event() {
-  gesture_swipe_event = {};
-  gesture_swipe_event.executed = false;
+void gebaar::io::Input::run_command(const gebaar::action::Command &command,
+                                    const recognized_gesture &gesture) {
+  if (command.empty()) {
+    return;
+  }
+  gebaar::action::template_values values{
+      gesture.fingers, gesture.dx,   gesture.dy, gesture.scale,
+      gesture.angle,   1,
+      gesture.device < GESTURE_MAX_DEVICES ? device_names[gesture.device]
+                                           : ""};
+  if (command.get_policy().limited()) {
+    values.steps =
+        scheduler.trigger(command, gesture.type, event_time_usec, values);
+    arm_scheduler();
+  }
+  if (values.steps == 0) {
+    return;
+  }
+  // Held back runs are late on purpose, only count the ones run right away
+  uint64_t now = gebaar::stats::now_usec();
+  if (now > event_time_usec) {
+    latency[gesture.type].trigger.record(now - event_time_usec);
+  }
+  launch(command, gesture.type, values);
 }
 
 /**
- * Reset pinch event struct to defaults
+ * Run the commands the scheduler held back that are due now
  */
-void gebaar::io::Input::reset_pinch_event() {
-  gesture_pinch_event = {};
-  gesture_pinch_event.scale = DEFAULT_SCALE;
-  gesture_pinch_event.executed = false;
+void gebaar::io::Input::run_scheduled() {
+  scheduler.expire(gebaar::stats::now_usec(),
+                   [this](const gebaar::action::Command &command, int group,
+                          const gebaar::action::template_values &values) {
+                     launch(command, static_cast<gesture_type>(group), values);
+                   });
+  arm_scheduler();
 }
 
 /**
- * Pinch one_shot gesture handle
- * @param new_scale last reported scale between the fingers
+ * Wake up when the scheduler has the next held back command due
  */
-void gebaar::io::Input::handle_one_shot_pinch(double new_scale) {
-  if (new_scale > gesture_pinch_event.scale) { // Scale up
-    // Add 1 to required distance to get 2 > x > 1
-    if (new_scale > 1 + config->settings.pinch_threshold) {
-      std::system(config->pinch_commands[config->PINCH_IN].c_str());
-      gesture_pinch_event.executed = true;
-    }
-  } else { // Scale Down
-    // Substract from 1 to have inverted value for pinch in gesture
-    if (gesture_pinch_event.scale < 1 - config->settings.pinch_threshold) {
-      std::system(config->pinch_commands[config->PINCH_OUT].c_str());
-      gesture_pinch_event.executed = true;
-    }
+void gebaar::io::Input::arm_scheduler() {
+  if (scheduler_timer < 0) {
+    return;
   }
+  uint64_t due = scheduler.next_due();
+  uint64_t now = gebaar::stats::now_usec();
+  // 0 disarms, anything overdue fires right away
+  reactor.arm_timer(scheduler_timer, due == 0 ? 0 : due > now ? due - now : 1);
 }
 
 /**
- * Pinch continous gesture handle
- * Calculates the trigger value according to current step
- * @param new_scale last reported scale between the fingers
+ * Hand a command to its helper, or to the executor without waiting for it.
+ * Native actions are injected right away, repeated once per step.
+ * Templates are filled in with the gesture parameters first. A command that
+ * collapses steps and has no {steps} gets their count as its last argument
+ * @param command pre-parsed command to run
+ * @param type gesture the command is bound to
+ * @param values gesture parameters
  */
-void gebaar::io::Input::handle_continouos_pinch(double new_scale) {
-  int step = gesture_pinch_event.step == 0 ? gesture_pinch_event.step + 1
-                                           : gesture_pinch_event.step;
-  double trigger = 1 + (config->settings.pinch_threshold * step);
-
-  if (new_scale > gesture_pinch_event.scale) { // Scale up
-    if (new_scale >= trigger) {
-      std::system(config->pinch_commands[config->PINCH_IN].c_str());
-      inc_step(gesture_pinch_event.step);
+void gebaar::io::Input::launch(const gebaar::action::Command &command,
+                               gesture_type type,
+                               const gebaar::action::template_values &values) {
+  if (command.is_native()) {
+    uint64_t launch_start = gebaar::stats::now_usec();
+    uinput.send(command.get_native(), values.steps);
+    latency[type].spawn.record(gebaar::stats::now_usec() - launch_start);
+    return;
+  }
+  const gebaar::action::Command *target = &command;
+  gebaar::action::Command counted;
+  if (command.get_policy().collapse &&
+      !command.uses(gebaar::action::PARAM_STEPS)) {
+    counted = command.with_argument(std::to_string(values.steps));
+    target = &counted;
+  }
+  if (target->is_template() && !target->fill(values, command_text)) {
+    std::cerr << "Command too long: " << target->get_line() << std::endl;
+    return;
+  }
+
+  uint64_t launch_start = gebaar::stats::now_usec();
+  if (target->is_helper()) {
+    if (target->is_template()) {
+      helpers.send(*target, command_text.text, command_text.length);
+    } else {
+      helpers.send(*target);
     }
-  } else { // Scale down
-    if (new_scale <= trigger) {
-      std::system(config->pinch_commands[config->PINCH_OUT].c_str());
-      dec_step(gesture_pinch_event.step);
+  } else {
+    unsigned int max_in_flight =
+        type == GESTURE_SWIPE   ? config->settings.swipe_max_in_flight
+        : type == GESTURE_PINCH ? config->settings.pinch_max_in_flight
+                                : 0;
+    if (target->is_template()) {
+      executor.spawn(command_text.argv, type, max_in_flight);
+    } else {
+      executor.spawn(*target, type, max_in_flight);
     }
   }
+  latency[type].spawn.record(gebaar::stats::now_usec() - launch_start);
 }
 
 /**
- * Pinch Gesture
- * Currently supporting only "one shot" pinch-in and pinch-out gestures.
- * @param gev Gesture Event
- * @param begin Boolean to denote begin or continuation of gesture.
- **/
-void gebaar::io::Input::handle_pinch_event(libinput_event_gesture *gev,
-                                           bool begin) {
-  if (begin) {
-    reset_pinch_event();
-    gesture_pinch_event.fingers = libinput_event_gesture_get_finger_count(gev);
-  } else {
-    double new_scale = libinput_event_gesture_get_scale(gev);
-    if (config->settings.pinch_one_shot && !gesture_pinch_event.executed)
-      handle_one_shot_pinch(new_scale);
-    if (!config->settings.pinch_one_shot)
-      handle_continouos_pinch(new_scale);
-    gesture_pinch_event.scale = new_scale;
+ * Record how long the gesture event waited before we got to it
+ * @param event Gesture Event
+ */
+void gebaar::io::Input::record_event_time(const gesture_event &event) {
+  uint64_t now = gebaar::stats::now_usec();
+  if (now > event.time_usec) {
+    latency[gesture_of(event.type)].dwell.record(now - event.time_usec);
   }
 }
 
 /**
- * This event has no coordinates, so it's an event that gives us a begin or end
- * signal. If it begins, we get the amount of fingers used. If it ends, we check
- * what kind of gesture we received.
- *
- * @param gev Gesture Event
- * @param begin Boolean to denote begin or end of gesture
+ * Record every gesture event we handle to a trace file
+ * @param path trace file to write
+ * @return bool
+ */
+bool gebaar::io::Input::start_recording(const std::string &path) {
+  trace = std::make_unique<TraceWriter>();
+  if (!trace->open(path)) {
+    trace.reset();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Append a gesture event to the trace, flushing at the end of every gesture
+ * so a killed daemon still leaves complete gestures behind
+ * @param event Gesture Event
  */
-void gebaar::io::Input::handle_swipe_event_without_coords(
-    libinput_event_gesture *gev, bool begin) {
-  if (begin) {
-    gesture_swipe_event.fingers = libinput_event_gesture_get_finger_count(gev);
-  }
-  // This executed when fingers left the touchpad
-  else {
-    if (!gesture_swipe_event.executed &&
-        config->settings.swipe_trigger_on_release) {
-      trigger_swipe_command();
+void gebaar::io::Input::record_trace(const gesture_event &event) {
+  trace->write(event);
+  if (ends_gesture(event.type)) {
+    trace->flush();
+  }
+}
+
+/**
+ * Print the startup breakdown and latency histograms of every gesture type,
+ * all values in microseconds
+ * @param out stream to print to
+ */
+void gebaar::io::Input::print_stats(std::ostream &out) const {
+  gebaar::stats::startup.print(out);
+  out << std::endl;
+  out << std::left << std::setw(16) << "latency (usec)" << std::right
+      << std::setw(8) << "count" << std::setw(10) << "min" << std::setw(10)
+      << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+      << std::setw(10) << "max" << std::endl;
+  for (int type = 0; type < GESTURE_TYPE_COUNT; ++type) {
+    const char *name = gesture_name(static_cast<gesture_type>(type));
+    const std::pair<const char *, const gebaar::stats::Histogram *> rows[] = {
+        {"dwell", &latency[type].dwell},
+        {"trigger", &latency[type].trigger},
+        {"spawn", &latency[type].spawn}};
+    for (const auto &row : rows) {
+      out << std::left << std::setw(6) << name << std::setw(10) << row.first
+          << std::right;
+      row.second->print(out);
+      out << std::endl;
     }
-    reset_swipe_event();
   }
+  out << "events " << handled_events << ", coalesced " << coalesced_events
+      << std::endl;
+  // Idle power shows in how often the loop wakes up, not in event counts
+  uint64_t wakeups = reactor.get_wakeups();
+  double seconds =
+      loop_start_usec == 0
+          ? 0
+          : (gebaar::stats::now_usec() - loop_start_usec) / 1000000.0;
+  auto flags = out.flags();
+  auto precision = out.precision();
+  out << "wakeups " << wakeups << " (" << std::fixed << std::setprecision(2)
+      << (seconds > 0 ? wakeups / seconds : 0.0) << "/s), input "
+      << source_wakeups << std::endl;
+  out.flags(flags);
+  out.precision(precision);
 }
 
 /**
- * Swipe events with coordinates, add it to the current tally
- * @param gev Gesture Event
+ * Route signals through the reactor: SIGCHLD reaps finished commands,
+ * SIGUSR1 prints statistics, SIGHUP reloads the configuration and
+ * SIGINT/SIGTERM stop the loop
+ * @return bool
  */
-void gebaar::io::Input::handle_swipe_event_with_coords(
-    libinput_event_gesture *gev) {
-  if (config->settings.swipe_one_shot && gesture_swipe_event.executed)
-    return;
+bool gebaar::io::Input::initialize_signals() {
+  return reactor.watch_signal(SIGCHLD, [this] { executor.reap(); }) &&
+         reactor.watch_signal(SIGUSR1, [this] { print_stats(std::cout); }) &&
+         reactor.watch_signal(SIGHUP, [this] { reload_config(); }) &&
+         reactor.watch_signal(SIGINT, [this] { shutdown(); }) &&
+         reactor.watch_signal(SIGTERM, [this] { shutdown(); });
+}
 
-  // Since swipe gesture counts in dpi we have to convert
-  int threshold_x = config->settings.swipe_threshold * SWIPE_X_THRESHOLD *
-                    gesture_swipe_event.step;
-  int threshold_y = config->settings.swipe_threshold * SWIPE_Y_THRESHOLD *
-                    gesture_swipe_event.step;
-  gesture_swipe_event.x += libinput_event_gesture_get_dx_unaccelerated(gev);
-  gesture_swipe_event.y += libinput_event_gesture_get_dy_unaccelerated(gev);
-  if (abs(gesture_swipe_event.x) > threshold_x ||
-      abs(gesture_swipe_event.y) > threshold_y) {
-    trigger_swipe_command();
-    gesture_swipe_event.executed = true;
-    inc_step(gesture_swipe_event.step);
+/**
+ * Stop the loop, printing statistics first if asked to
+ */
+void gebaar::io::Input::shutdown() {
+  if (stats_on_exit) {
+    print_stats(std::cout);
   }
+  reactor.stop();
 }
 
 /**
- * Making calculation for swipe direction and triggering
- * command accordingly
+ * Re-read the configuration file in the background, a file that fails to
+ * parse leaves the current configuration in place
  */
-void gebaar::io::Input::trigger_swipe_command() {
-  double x = gesture_swipe_event.x;
-  double y = gesture_swipe_event.y;
-  int swipe_type = 5;                 // middle = no swipe
-                                      // 1 = left_up, 2 = up, 3 = right_up...
-                                      // 1 2 3
-                                      // 4 5 6
-                                      // 7 8 9
-  const double OBLIQUE_RATIO = 0.414; // =~ tan(22.5);
-
-  if (abs(x) > abs(y)) {
-    // left or right swipe
-    swipe_type += x < 0 ? -1 : 1;
-
-    // check for oblique swipe
-    if (abs(y) / abs(x) > OBLIQUE_RATIO) {
-      swipe_type += y < 0 ? -3 : 3;
-    }
-  } else {
-    // up of down swipe
-    swipe_type += y < 0 ? -3 : 3;
+void gebaar::io::Input::reload_config() { loader.request(config->get_path()); }
 
-    // check for oblique swipe
-    if (abs(x) / abs(y) > OBLIQUE_RATIO) {
-      swipe_type += x < 0 ? -1 : 1;
-    }
+/**
+ * Swap in the snapshot the loader finished parsing
+ */
+void gebaar::io::Input::apply_config() {
+  auto snapshot = loader.take();
+  if (!snapshot) {
+    return;
   }
+  // The bus, the stream and the input devices are set up once at startup
+  const auto &before = config->settings;
+  const auto &after = snapshot->settings;
+  if (before.bus_enabled != after.bus_enabled ||
+      before.bus_socket != after.bus_socket ||
+      before.stream_enabled != after.stream_enabled ||
+      before.stream_socket != after.stream_socket ||
+      before.stream_rate != after.stream_rate ||
+      before.input_backend != after.input_backend ||
+      before.input_devices != after.input_devices ||
+      (!config->bindings.uses_modifiers() &&
+       snapshot->bindings.uses_modifiers())) {
+    std::cerr << "Changes to the bus, stream and input settings and new "
+                 "modifier bindings take effect after a restart"
+              << std::endl;
+  }
+  config = snapshot;
+  // States of the old sequence DFA mean nothing in the new one, and held
+  // back commands belong to the old bindings
+  sequence_state = config->sequences.start();
+  scheduler.clear();
+  arm_scheduler();
+  if (config->uses_uinput()) {
+    uinput.initialize();
+  }
+  recognizer.set_config(snapshot);
+  helpers.set_helpers(config->helpers);
+}
 
-  if (gesture_swipe_event.fingers == 3) {
-    std::system(config->swipe_three_commands[swipe_type].c_str());
-  } else if (gesture_swipe_event.fingers == 4) {
-    std::system(config->swipe_four_commands[swipe_type].c_str());
+/**
+ * Event source readiness. A source that hangs up or fails would otherwise
+ * be reported readable forever, so it ends the loop
+ * @param events epoll events
+ */
+void gebaar::io::Input::handle_source(uint32_t events) {
+  ++source_wakeups;
+  if (events & EPOLLIN) {
+    handle_event();
+  }
+  if (events & (EPOLLHUP | EPOLLERR)) {
+    std::cerr << "Lost the input event source" << std::endl;
+    reactor.remove(source->get_fd());
+    reactor.stop();
   }
 }
 
@@ -217,121 +358,204 @@ void gebaar::io::Input::trigger_swipe_command() {
  * @return bool
  */
 bool gebaar::io::Input::initialize() {
-  initialize_context();
-  return gesture_device_exists();
+  if (!reactor.initialize() || !executor.initialize() ||
+      !initialize_signals()) {
+    return false;
+  }
+  helpers.set_helpers(config->helpers);
+  // Created up front, so the first native action is as fast as the rest
+  if (config->uses_uinput() && !uinput.initialize()) {
+    std::cerr << "Native actions and continuous output will not work"
+              << std::endl;
+  }
+  source->set_device_listener(
+      [this](unsigned int slot, const device_info *device) {
+        if (device != nullptr) {
+          recognizer.add_device(slot, device->name, device->width,
+                                device->height);
+          if (slot < GESTURE_MAX_DEVICES) {
+            snprintf(device_names[slot], DEVICE_NAME_SIZE, "%s",
+                     device->name.c_str());
+          }
+        } else {
+          recognizer.remove_device(slot);
+          if (slot < GESTURE_MAX_DEVICES) {
+            device_names[slot][0] = '\0';
+          }
+        }
+      });
+  if (!source->initialize()) {
+    return false;
+  }
+  gebaar::stats::startup.mark("source");
+
+  if (!loader.initialize() ||
+      !reactor.add(loader.get_fd(), [this](uint32_t) { apply_config(); })) {
+    return false;
+  }
+  if (config->settings.bus_enabled) {
+    bus_enabled = bus.initialize(config->settings.bus_socket);
+    if (!bus_enabled) {
+      std::cerr << "Not publishing gestures" << std::endl;
+    }
+  }
+  if (config->settings.stream_enabled) {
+    if (stream.initialize(config->settings.stream_socket,
+                          config->settings.stream_rate)) {
+      recognizer.set_progress_listener(
+          [this](const gesture_progress &progress) {
+            stream.publish(progress);
+          });
+    } else {
+      std::cerr << "Not streaming gesture progress" << std::endl;
+    }
+  }
+
+  scheduler_timer = reactor.add_timer([this] { run_scheduled(); });
+  if (scheduler_timer < 0) {
+    std::cerr << "Commands held back by their limits will not run"
+              << std::endl;
+  }
+  continuous_timer = reactor.add_timer([this] { flush_continuous(); });
+  if (continuous_timer < 0) {
+    std::cerr << "Continuous output will not work" << std::endl;
+  }
+  sequence_timer = reactor.add_timer(
+      [this] { sequence_state = config->sequences.start(); });
+  if (sequence_timer < 0) {
+    std::cerr << "Sequences will not time out" << std::endl;
+  }
+
+  // Editors tend to write a file in several steps, settle before reloading
+  reload_timer = reactor.add_timer([this] { reload_config(); });
+  if (reload_timer < 0 || !reactor.watch_file(config->get_path(), [this] {
+        reactor.arm_timer(reload_timer, CONFIG_RELOAD_DELAY_USEC);
+      })) {
+    std::cerr << "Not watching " << config->get_path() << " for changes"
+              << std::endl;
+  }
+  if (!reactor.add(source->get_fd(),
+                   [this](uint32_t events) { handle_source(events); })) {
+    return false;
+  }
+  gebaar::stats::startup.mark("ready");
+  return true;
 }
 
 /**
- * Run a poll loop on the file descriptor that libinput gives us
+ * Run the reactor until we are told to stop
  */
 void gebaar::io::Input::start_loop() {
-  struct pollfd fds {};
-  fds.fd = libinput_get_fd(libinput);
-  fds.events = POLLIN;
-  fds.revents = 0;
-
-  while (poll(&fds, 1, -1) > -1) {
-    handle_event();
-  }
+  loop_start_usec = gebaar::stats::now_usec();
+  reactor.run();
 }
 
-gebaar::io::Input::~Input() { libinput_unref(libinput); }
+gebaar::io::Input::~Input() = default;
 
 /**
- * Check if there's a device that supports gestures on this system
- * @return
+ * Drain the event source and feed every gesture event to the recognizer.
+ * Every event is recorded, but consecutive updates of a gesture that piled
+ * up while we were busy reach the recognizer as one
  */
-bool gebaar::io::Input::gesture_device_exists() {
-  bool device_found = false;
-
-  while ((libinput_event = libinput_get_event(libinput)) != nullptr) {
-    auto device = libinput_event_get_device(libinput_event);
-    if (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_GESTURE)) {
-      device_found = true;
+void gebaar::io::Input::handle_event() {
+  gesture_event events[EVENT_BATCH_SIZE];
+  size_t count;
+  while ((count = source->read_events(events, EVENT_BATCH_SIZE)) > 0) {
+    for (size_t i = 0; i < count; ++i) {
+      record_event_time(events[i]);
+      if (trace) {
+        record_trace(events[i]);
+      }
+    }
+    size_t kept = coalesce_updates(events, count);
+    handled_events += count;
+    coalesced_events += count - kept;
+    bool continuous_output = uinput.is_open() &&
+                             (config->settings.scroll_fingers > 0 ||
+                              config->settings.zoom_fingers > 0);
+    for (size_t i = 0; i < kept; ++i) {
+      event_time_usec = events[i].time_usec;
+      if (continuous_output) {
+        follow_continuous(events[i]);
+      }
+      recognizer.handle(events[i]);
     }
-
-    libinput_event_destroy(libinput_event);
-    libinput_dispatch(libinput);
   }
-  return device_found;
 }
 
 /**
- * Handle an event from libinput and run the appropriate action per event type
+ * Feed swipes and pinches with the configured finger counts to the
+ * continuous output. Nothing is written here, a timer flushes what added up
+ * at the configured rate
+ * @param event Gesture Event
  */
-void gebaar::io::Input::handle_event() {
-  libinput_dispatch(libinput);
-  while ((libinput_event = libinput_get_event(libinput))) {
-    switch (libinput_event_get_type(libinput_event)) {
-    case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
-      handle_swipe_event_without_coords(
-          libinput_event_get_gesture_event(libinput_event), true);
-      break;
-    case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
-      handle_swipe_event_with_coords(
-          libinput_event_get_gesture_event(libinput_event));
-      break;
-    case LIBINPUT_EVENT_GESTURE_SWIPE_END:
-      handle_swipe_event_without_coords(
-          libinput_event_get_gesture_event(libinput_event), false);
-      break;
-    case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
-      handle_pinch_event(libinput_event_get_gesture_event(libinput_event),
-                         true);
-      break;
-    case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
-      handle_pinch_event(libinput_event_get_gesture_event(libinput_event),
-                         false);
-      break;
-    case LIBINPUT_EVENT_GESTURE_PINCH_END:
-      handle_pinch_event(libinput_event_get_gesture_event(libinput_event),
-                         false);
-      break;
-    case LIBINPUT_EVENT_NONE:
-      break;
-    case LIBINPUT_EVENT_DEVICE_ADDED:
-      break;
-    case LIBINPUT_EVENT_DEVICE_REMOVED:
-      break;
-    case LIBINPUT_EVENT_KEYBOARD_KEY:
-      break;
-    case LIBINPUT_EVENT_POINTER_MOTION:
-      break;
-    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
-      break;
-    case LIBINPUT_EVENT_POINTER_BUTTON:
-      break;
-    case LIBINPUT_EVENT_POINTER_AXIS:
-      break;
-    case LIBINPUT_EVENT_TOUCH_DOWN:
-      break;
-    case LIBINPUT_EVENT_TOUCH_UP:
-      break;
-    case LIBINPUT_EVENT_TOUCH_MOTION:
-      break;
-    case LIBINPUT_EVENT_TOUCH_CANCEL:
-      break;
-    case LIBINPUT_EVENT_TOUCH_FRAME:
-      break;
-    case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
-      break;
-    case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
-      break;
-    case LIBINPUT_EVENT_TABLET_TOOL_TIP:
-      break;
-    case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
-      break;
-    case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
-      break;
-    case LIBINPUT_EVENT_TABLET_PAD_RING:
-      break;
-    case LIBINPUT_EVENT_TABLET_PAD_STRIP:
-      break;
-    case LIBINPUT_EVENT_SWITCH_TOGGLE:
-      break;
+void gebaar::io::Input::follow_continuous(const gesture_event &event) {
+  const auto &settings = config->settings;
+  unsigned int slot = event.device < GESTURE_MAX_DEVICES ? event.device : 0;
+  if (event.fingers == settings.scroll_fingers) {
+    if (event.type == EVENT_SWIPE_BEGIN) {
+      continuous.reset();
+    } else if (event.type == EVENT_SWIPE_UPDATE) {
+      // Fingers up scroll up, unless scrolling is natural
+      double speed = settings.scroll_speed / SWIPE_UNITS_PER_MM;
+      double sign = settings.scroll_natural ? -1 : 1;
+      continuous.scroll(sign * event.dx * speed, -sign * event.dy * speed);
     }
+  }
+  if (event.fingers == settings.zoom_fingers) {
+    if (event.type == EVENT_PINCH_BEGIN) {
+      continuous.reset();
+      zoom_scale[slot] = DEFAULT_SCALE;
+    } else if (event.type == EVENT_PINCH_UPDATE && event.scale > 0 &&
+               zoom_scale[slot] > 0) {
+      // Every doubling of the scale zooms in by the same amount
+      continuous.zoom(std::log2(event.scale / zoom_scale[slot]) *
+                      settings.zoom_speed * WHEEL_HI_RES_PER_CLICK);
+      zoom_scale[slot] = event.scale;
+    }
+  }
+  if (!continuous_armed && continuous_timer >= 0 && continuous.pending()) {
+    reactor.arm_timer(continuous_timer, 1000000 / settings.continuous_rate);
+    continuous_armed = true;
+  }
+}
 
-    libinput_event_destroy(libinput_event);
-    libinput_dispatch(libinput);
+/**
+ * Write out the continuous output that added up since the last flush
+ */
+void gebaar::io::Input::flush_continuous() {
+  continuous_armed = false;
+  continuous.flush(config->settings.zoom_keys);
+}
+
+/**
+ * Fold runs of update events of the same gesture into their first event:
+ * deltas and angles add up, the scale is absolute so the latest one wins
+ * @param events batch of events, compacted in place
+ * @param count number of events in the batch
+ * @return number of events left
+ */
+size_t gebaar::io::Input::coalesce_updates(gesture_event *events,
+                                           size_t count) {
+  size_t kept = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const gesture_event &event = events[i];
+    if (kept > 0) {
+      gesture_event &last = events[kept - 1];
+      bool update = event.type == EVENT_SWIPE_UPDATE ||
+                    event.type == EVENT_PINCH_UPDATE;
+      if (update && last.type == event.type && last.device == event.device &&
+          last.fingers == event.fingers &&
+          last.modifiers == event.modifiers) {
+        last.dx += event.dx;
+        last.dy += event.dy;
+        last.angle += event.angle;
+        last.scale = event.scale;
+        last.time_usec = event.time_usec;
+        continue;
+      }
+    }
+    events[kept++] = event;
   }
+  return kept;
 }
@@ -19,37 +19,36 @@
 #ifndef GEBAAR_INPUT_HPP
 #define GEBAAR_INPUT_HPP
 
-#include <libinput.h>
-#include <fcntl.h>
-#include <zconf.h>
 #include "../config/config.h"
-
-#define DEFAULT_SCALE           1.0
-#define SWIPE_X_THRESHOLD       1000
-#define SWIPE_Y_THRESHOLD       500
+#include "../config/loader.h"
+#include "../action/executor.h"
+#include "../action/helper_pool.h"
+#include "../action/continuous.h"
+#include "../action/scheduler.h"
+#include "../action/uinput.h"
+#include "../gesture/recognizer.h"
+#include "../ipc/bus.h"
+#include "../ipc/stream.h"
+#include "../stats/histogram.h"
+#include "event_source.h"
+#include "reactor.h"
+#include "trace.h"
+
+#define EVENT_BATCH_SIZE        64
+#define CONFIG_RELOAD_DELAY_USEC 200000
+#define DEVICE_NAME_SIZE        128
 
 namespace gebaar::io {
-    struct gesture_swipe_event {
-        int fingers;
-        double x;
-        double y;
-
-        bool executed;
-        int step;
-    };
-
-    struct gesture_pinch_event {
-        int fingers;
-        double scale;
-        double angle;
-
-        bool executed;
-        int step;
+    struct gesture_latency {
+        gebaar::stats::Histogram dwell;
+        gebaar::stats::Histogram trigger;
+        gebaar::stats::Histogram spawn;
     };
 
     class Input {
     public:
-        Input(std::shared_ptr<gebaar::config::Config> const& config_ptr);
+        Input(std::shared_ptr<const gebaar::config::Config> const& config_ptr, std::unique_ptr<EventSource> source,
+              bool stats_on_exit);
 
         ~Input();
 
@@ -57,68 +56,78 @@ namespace gebaar::io {
 
         void start_loop();
 
-    private:
-        std::shared_ptr<gebaar::config::Config> config;
+        void print_stats(std::ostream& out) const;
 
-        struct libinput* libinput;
-        struct libinput_event* libinput_event;
-        struct udev* udev;
+        bool start_recording(const std::string& path);
 
-        struct gesture_swipe_event gesture_swipe_event;
-        struct gesture_pinch_event gesture_pinch_event;
+        void handle_event();
 
-        bool initialize_context();
+    private:
+        std::shared_ptr<const gebaar::config::Config> config;
+        std::unique_ptr<EventSource> source;
+        gebaar::gesture::Recognizer recognizer;
+        gebaar::action::Executor executor;
+        gebaar::action::HelperPool helpers;
+        gebaar::action::Scheduler scheduler;
+        gebaar::action::VirtualInput uinput;
+        gebaar::action::ContinuousOutput continuous;
+        gebaar::action::command_buffer command_text;
+        // Fixed storage, held back commands keep pointing at their device
+        char device_names[GESTURE_MAX_DEVICES][DEVICE_NAME_SIZE] = {};
+        Reactor reactor;
+        gebaar::config::Loader loader;
+        gebaar::ipc::Stream stream;
+        gebaar::ipc::Bus bus;
+        bool bus_enabled = false;
 
-        bool gesture_device_exists();
+        bool stats_on_exit;
+        int reload_timer = -1;
+        int sequence_timer = -1;
+        int scheduler_timer = -1;
+        int continuous_timer = -1;
+        bool continuous_armed = false;
+        double zoom_scale[GESTURE_MAX_DEVICES] = {};
+        uint16_t sequence_state = 0;
+        uint64_t event_time_usec = 0;
+        uint64_t handled_events = 0;
+        uint64_t coalesced_events = 0;
+        uint64_t source_wakeups = 0;
+        uint64_t loop_start_usec = 0;
+        struct gesture_latency latency[gebaar::gesture::GESTURE_TYPE_COUNT];
+        std::unique_ptr<TraceWriter> trace;
 
-        static int open_restricted(const char* path, int flags, void* user_data)
-        {
-            int fd = open(path, flags);
-            return fd < 0 ? -errno : fd;
-        }
+        bool initialize_signals();
 
-        static void close_restricted(int fd, void* user_data)
-        {
-            close(fd);
-        }
+        void handle_source(uint32_t events);
 
-        constexpr static struct libinput_interface libinput_interface = {
-                .open_restricted = open_restricted,
-                .close_restricted = close_restricted,
-        };
+        void shutdown();
 
-        /*
-         * Decrements step of current trigger. Just to skip 0
-         * @param cur current step
-         */
-        inline void dec_step(int &cur) { --cur == 0 ? --cur : cur; }
+        void reload_config();
 
-        /*
-         * Increase step of current trigger. Just to pass -1
-         * @param cur current step
-         */
-        inline void inc_step(int &cur) { ++cur == 0 ? ++cur : cur; }
+        void apply_config();
 
-        void handle_event();
+        void record_event_time(const gebaar::gesture::gesture_event& event);
+
+        void record_trace(const gebaar::gesture::gesture_event& event);
 
-        /* Swipe event */
-        void reset_swipe_event();
+        static size_t coalesce_updates(gebaar::gesture::gesture_event* events, size_t count);
 
-        void handle_swipe_event_without_coords(libinput_event_gesture* gev, bool begin);
+        void dispatch(const gebaar::gesture::recognized_gesture& gesture);
 
-        void handle_swipe_event_with_coords(libinput_event_gesture* gev);
+        void run_command(const gebaar::action::Command& command, const gebaar::gesture::recognized_gesture& gesture);
 
-        void trigger_swipe_command();
+        void launch(const gebaar::action::Command& command, gebaar::gesture::gesture_type type,
+                    const gebaar::action::template_values& values);
 
-        /* Pinch event */
-        void reset_pinch_event();
+        void run_scheduled();
 
-        void handle_one_shot_pinch(double new_scale);
+        void arm_scheduler();
 
-        void handle_continouos_pinch(double new_scale);
+        void follow_continuous(const gebaar::gesture::gesture_event& event);
 
-        void handle_pinch_event(libinput_event_gesture* gev, bool begin);
+        void flush_continuous();
 
+        void follow_sequences(const gebaar::gesture::recognized_gesture& gesture);
     };
 }
 
@@ -0,0 +1,509 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libinput_source.h"
+#include <algorithm>
+#include "../stats/startup.h"
+#include "../util.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <linux/input.h>
+#include <pwd.h>
+
+/**
+ * Modifier keys we track, the left and right key of each modifier
+ */
+static const struct {
+  uint32_t key;
+  unsigned int modifier;
+} MODIFIER_KEYS[] = {
+    {KEY_LEFTSHIFT, gebaar::gesture::MODIFIER_SHIFT},
+    {KEY_RIGHTSHIFT, gebaar::gesture::MODIFIER_SHIFT},
+    {KEY_LEFTCTRL, gebaar::gesture::MODIFIER_CTRL},
+    {KEY_RIGHTCTRL, gebaar::gesture::MODIFIER_CTRL},
+    {KEY_LEFTALT, gebaar::gesture::MODIFIER_ALT},
+    {KEY_RIGHTALT, gebaar::gesture::MODIFIER_ALT},
+    {KEY_LEFTMETA, gebaar::gesture::MODIFIER_SUPER},
+    {KEY_RIGHTMETA, gebaar::gesture::MODIFIER_SUPER},
+};
+
+/**
+ * Libinput source that may skip udev seat enumeration
+ * @param use_path open touchpad device nodes directly instead of the seat
+ * @param device_paths device nodes to open, the ones found by the last seat
+ * enumeration if empty
+ * @param keep_keyboards listen to keyboards, for bindings with modifiers
+ */
+gebaar::io::LibinputSource::LibinputSource(
+    bool use_path, std::vector<std::string> device_paths, bool keep_keyboards)
+    : use_path(use_path), device_paths(std::move(device_paths)),
+      keep_keyboards(keep_keyboards) {}
+
+/**
+ * Initialize the libinput context
+ *
+ * @return bool
+ */
+bool gebaar::io::LibinputSource::initialize_context() {
+  udev = udev_new();
+  libinput = libinput_udev_create_context(&libinput_interface, nullptr, udev);
+  return libinput_udev_assign_seat(libinput, "seat0") == 0;
+}
+
+/**
+ * Open only the known touchpad device nodes, which is much cheaper than
+ * enumerating every input device of the seat
+ * @return bool false if none of them turned out to support gestures
+ */
+bool gebaar::io::LibinputSource::initialize_path() {
+  std::vector<std::string> paths =
+      device_paths.empty() ? read_device_cache() : device_paths;
+  if (paths.empty()) {
+    return false;
+  }
+  libinput = libinput_path_create_context(&libinput_interface, nullptr);
+  for (const auto &path : paths) {
+    if (libinput_path_add_device(libinput, path.c_str()) == nullptr) {
+      std::cerr << "Could not open " << path << std::endl;
+    }
+  }
+  if (gesture_device_exists()) {
+    gebaar::stats::startup.mark("devices");
+    return true;
+  }
+  std::cerr << "No gesture device among the configured devices, enumerating "
+               "the seat"
+            << std::endl;
+  libinput_unref(libinput);
+  libinput = nullptr;
+  gebaar::stats::startup.mark("path");
+  return false;
+}
+
+/**
+ * Initialize libinput. Having no gesture device yet is fine, touchpads
+ * plugged in later are picked up as they are added
+ * @return bool
+ */
+bool gebaar::io::LibinputSource::initialize() {
+  if (use_path && initialize_path()) {
+    return true;
+  }
+  if (!initialize_context()) {
+    std::cerr << "Could not assign the libinput seat" << std::endl;
+    return false;
+  }
+  gebaar::stats::startup.mark("context");
+
+  std::vector<std::string> device_nodes;
+  bool device_found = gesture_device_exists(&device_nodes);
+  gebaar::stats::startup.mark("devices");
+  if (device_found) {
+    write_device_cache(device_nodes);
+  } else {
+    std::cerr << "No gesture device yet, waiting for one" << std::endl;
+  }
+  return true;
+}
+
+/**
+ * File descriptor libinput signals new events on
+ * @return int
+ */
+int gebaar::io::LibinputSource::get_fd() const {
+  return libinput_get_fd(libinput);
+}
+
+gebaar::io::LibinputSource::~LibinputSource() {
+  for (auto device : devices) {
+    if (device != nullptr) {
+      libinput_device_unref(device);
+    }
+  }
+  if (libinput != nullptr) {
+    libinput_unref(libinput);
+  }
+}
+
+/**
+ * Check if there's a device that supports gestures on this system
+ * @param device_nodes if given, collects the device node of every device we
+ * listen to
+ * @return
+ */
+bool gebaar::io::LibinputSource::gesture_device_exists(
+    std::vector<std::string> *device_nodes) {
+  bool device_found = false;
+
+  while ((libinput_event = libinput_get_event(libinput)) != nullptr) {
+    auto device = libinput_event_get_device(libinput_event);
+    if (libinput_event_get_type(libinput_event) ==
+            LIBINPUT_EVENT_DEVICE_ADDED &&
+        filter_device(device)) {
+      if (makes_gestures(device)) {
+        device_found = true;
+        add_device(device);
+      }
+      if (device_nodes != nullptr) {
+        device_nodes->push_back(std::string("/dev/input/") +
+                                libinput_device_get_sysname(device));
+      }
+    }
+
+    libinput_event_destroy(libinput_event);
+    libinput_dispatch(libinput);
+  }
+  return device_found;
+}
+
+/**
+ * Find the device cache according to XDG spec
+ * @return path of the cache file, empty if there is no home directory
+ */
+std::string gebaar::io::LibinputSource::find_cache_file() {
+  std::string path = gebaar::util::stringFromCharArray(getenv("XDG_CACHE_HOME"));
+  if (path.empty()) {
+    path = gebaar::util::stringFromCharArray(getenv("HOME"));
+    if (path.empty()) {
+      path = getpwuid(getuid())->pw_dir;
+    }
+    if (!path.empty()) {
+      path.append("/.cache");
+    }
+  }
+  if (!path.empty()) {
+    path.append("/gebaar/devices");
+  }
+  return path;
+}
+
+/**
+ * Device nodes of the gesture devices the last seat enumeration found
+ * @return one device node per line of the cache
+ */
+std::vector<std::string> gebaar::io::LibinputSource::read_device_cache() {
+  std::vector<std::string> device_nodes;
+  std::string path = find_cache_file();
+  if (path.empty()) {
+    return device_nodes;
+  }
+  std::ifstream cache(path);
+  std::string line;
+  while (std::getline(cache, line)) {
+    if (!line.empty()) {
+      device_nodes.push_back(line);
+    }
+  }
+  return device_nodes;
+}
+
+/**
+ * Remember the gesture devices for the next start with the path backend
+ * @param device_nodes device nodes to cache
+ */
+void gebaar::io::LibinputSource::write_device_cache(
+    const std::vector<std::string> &device_nodes) {
+  std::string path = find_cache_file();
+  if (path.empty()) {
+    return;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(),
+                                      error);
+  std::ofstream cache(path, std::ios::trunc);
+  for (const auto &node : device_nodes) {
+    cache << node << std::endl;
+  }
+}
+
+/**
+ * Look up everything we want to know about a device once, so events never
+ * have to ask libinput again
+ * @param device libinput device
+ * @return device record
+ */
+gebaar::io::device_info
+gebaar::io::LibinputSource::describe_device(struct libinput_device *device) {
+  device_info info{libinput_device_get_name(device), 0, 0};
+  if (libinput_device_get_size(device, &info.width, &info.height) != 0) {
+    info.width = 0;
+    info.height = 0;
+  }
+  return info;
+}
+
+/**
+ * Pull pending events out of libinput, keeping the gesture events. libinput
+ * reads the device once per call, whatever arrives meanwhile is left for the
+ * next call
+ * @param events buffer to fill
+ * @param max size of the buffer
+ * @return number of gesture events written
+ */
+size_t gebaar::io::LibinputSource::read_events(
+    gebaar::gesture::gesture_event *events, size_t max) {
+  size_t count = 0;
+  libinput_dispatch(libinput);
+  while (count < max && (libinput_event = libinput_get_event(libinput))) {
+    switch (libinput_event_get_type(libinput_event)) {
+    case LIBINPUT_EVENT_DEVICE_ADDED:
+      if (filter_device(libinput_event_get_device(libinput_event)) &&
+          makes_gestures(libinput_event_get_device(libinput_event))) {
+        add_device(libinput_event_get_device(libinput_event));
+      }
+      break;
+    case LIBINPUT_EVENT_DEVICE_REMOVED:
+      remove_device(libinput_event_get_device(libinput_event));
+      break;
+    case LIBINPUT_EVENT_KEYBOARD_KEY:
+      track_modifiers(libinput_event);
+      break;
+    default:
+      // Only devices with a slot make gestures, skip everything else early
+      if (libinput_device_get_user_data(
+              libinput_event_get_device(libinput_event)) != nullptr &&
+          convert_event(libinput_event, events[count])) {
+        ++count;
+      }
+    }
+    libinput_event_destroy(libinput_event);
+  }
+  return count;
+}
+
+/**
+ * Touchpads make gestures, touchscreens make the raw touches we recognize
+ * taps and edge swipes from
+ * @param device libinput device
+ * @return bool
+ */
+bool gebaar::io::LibinputSource::makes_gestures(
+    struct libinput_device *device) {
+  return libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_GESTURE) ||
+         libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_TOUCH);
+}
+
+/**
+ * Stop listening to a device we have no use for. Disabling its events makes
+ * libinput close it in our context only, so pointer motion, tablets and
+ * (without modifier bindings) typing no longer wake the daemon up, while
+ * the compositor keeps getting everything
+ * @param device device that was added
+ * @return bool true if we listen to the device
+ */
+bool gebaar::io::LibinputSource::filter_device(
+    struct libinput_device *device) const {
+  if (makes_gestures(device) ||
+      (keep_keyboards &&
+       libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_KEYBOARD))) {
+    return true;
+  }
+  libinput_device_config_send_events_set_mode(
+      device, LIBINPUT_CONFIG_SEND_EVENTS_DISABLED);
+  return false;
+}
+
+/**
+ * Give a gesture device a slot, so gestures on several touchpads at once are
+ * recognized separately. Devices beyond the last slot are ignored
+ * @param device device that was added
+ */
+void gebaar::io::LibinputSource::add_device(struct libinput_device *device) {
+  for (unsigned int slot = 0; slot < GESTURE_MAX_DEVICES; ++slot) {
+    if (devices[slot] == nullptr) {
+      devices[slot] = libinput_device_ref(device);
+      records[slot] = describe_device(device);
+      libinput_device_set_user_data(
+          device, reinterpret_cast<void *>(uintptr_t{slot + 1}));
+      if (on_device) {
+        on_device(slot, &records[slot]);
+      }
+      return;
+    }
+  }
+  std::cerr << "Too many gesture devices, ignoring "
+            << libinput_device_get_name(device) << std::endl;
+}
+
+/**
+ * Free the slot of a removed device
+ * @param device device that was removed
+ */
+void gebaar::io::LibinputSource::remove_device(
+    struct libinput_device *device) {
+  if (libinput_device_get_user_data(device) == nullptr) {
+    return;
+  }
+  unsigned int slot = slot_of(device);
+  libinput_device_set_user_data(device, nullptr);
+  devices[slot] = nullptr;
+  records[slot] = device_info();
+  libinput_device_unref(device);
+  if (on_device) {
+    on_device(slot, nullptr);
+  }
+}
+
+/**
+ * Slot a device was given when it was added
+ * @param device libinput device
+ * @return slot, 0 for devices without one
+ */
+unsigned int
+gebaar::io::LibinputSource::slot_of(struct libinput_device *device) {
+  auto data = reinterpret_cast<uintptr_t>(libinput_device_get_user_data(device));
+  return data == 0 ? 0 : static_cast<unsigned int>(data - 1);
+}
+
+/**
+ * Follow the modifier keys held down on any keyboard
+ * @param event libinput keyboard key event
+ */
+void gebaar::io::LibinputSource::track_modifiers(struct libinput_event *event) {
+  auto kev = libinput_event_get_keyboard_event(event);
+  uint32_t key = libinput_event_keyboard_get_key(kev);
+  for (size_t i = 0; i < sizeof(MODIFIER_KEYS) / sizeof(MODIFIER_KEYS[0]);
+       ++i) {
+    if (MODIFIER_KEYS[i].key == key) {
+      if (libinput_event_keyboard_get_key_state(kev) ==
+          LIBINPUT_KEY_STATE_PRESSED) {
+        modifier_keys |= 1u << i;
+      } else {
+        modifier_keys &= ~(1u << i);
+      }
+      return;
+    }
+  }
+}
+
+/**
+ * Modifiers currently held, left and right keys count the same
+ * @return gebaar::gesture::modifier mask
+ */
+unsigned int gebaar::io::LibinputSource::modifiers() const {
+  unsigned int mask = 0;
+  for (size_t i = 0; i < sizeof(MODIFIER_KEYS) / sizeof(MODIFIER_KEYS[0]);
+       ++i) {
+    if (modifier_keys & (1u << i)) {
+      mask |= MODIFIER_KEYS[i].modifier;
+    }
+  }
+  return mask;
+}
+
+/**
+ * Translate a libinput gesture or touch event, everything else is dropped
+ * @param event libinput event
+ * @param out gesture event to fill
+ * @return bool false if the event is not a gesture event
+ */
+bool gebaar::io::LibinputSource::convert_event(
+    struct libinput_event *event, gebaar::gesture::gesture_event &out) const {
+  using namespace gebaar::gesture;
+
+  switch (libinput_event_get_type(event)) {
+  case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+    out.type = EVENT_SWIPE_BEGIN;
+    break;
+  case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+    out.type = EVENT_SWIPE_UPDATE;
+    break;
+  case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+    out.type = EVENT_SWIPE_END;
+    break;
+  case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+    out.type = EVENT_PINCH_BEGIN;
+    break;
+  case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+    out.type = EVENT_PINCH_UPDATE;
+    break;
+  case LIBINPUT_EVENT_GESTURE_PINCH_END:
+    out.type = EVENT_PINCH_END;
+    break;
+#ifdef HAVE_LIBINPUT_HOLD
+  case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN:
+    out.type = EVENT_HOLD_BEGIN;
+    break;
+  case LIBINPUT_EVENT_GESTURE_HOLD_END:
+    out.type = EVENT_HOLD_END;
+    break;
+#endif
+  case LIBINPUT_EVENT_TOUCH_DOWN:
+    out.type = EVENT_TOUCH_DOWN;
+    break;
+  case LIBINPUT_EVENT_TOUCH_MOTION:
+    out.type = EVENT_TOUCH_MOTION;
+    break;
+  case LIBINPUT_EVENT_TOUCH_UP:
+    out.type = EVENT_TOUCH_UP;
+    break;
+  case LIBINPUT_EVENT_TOUCH_CANCEL:
+    out.type = EVENT_TOUCH_CANCEL;
+    break;
+  default:
+    return false;
+  }
+
+  out.fingers = 0;
+  out.dx = 0;
+  out.dy = 0;
+  out.scale = 1.0;
+  out.angle = 0;
+  out.cancelled = false;
+  out.modifiers = modifiers();
+  out.device = slot_of(libinput_event_get_device(event));
+  out.slot = 0;
+  out.x = 0;
+  out.y = 0;
+
+  if (gesture_of(out.type) == GESTURE_TOUCH) {
+    auto tev = libinput_event_get_touch_event(event);
+    out.time_usec = libinput_event_touch_get_time_usec(tev);
+    // Single touch devices have no slots
+    out.slot = out.type == EVENT_TOUCH_CANCEL
+                   ? 0
+                   : std::max(libinput_event_touch_get_slot(tev), 0);
+    if (out.type == EVENT_TOUCH_DOWN || out.type == EVENT_TOUCH_MOTION) {
+      out.x = libinput_event_touch_get_x_transformed(tev, TOUCH_RANGE) /
+              double(TOUCH_RANGE);
+      out.y = libinput_event_touch_get_y_transformed(tev, TOUCH_RANGE) /
+              double(TOUCH_RANGE);
+    }
+    return true;
+  }
+
+  auto gev = libinput_event_get_gesture_event(event);
+  out.fingers = libinput_event_gesture_get_finger_count(gev);
+  out.time_usec = libinput_event_gesture_get_time_usec(gev);
+
+  // libinput only answers these for the event types that carry them
+  if (out.type == EVENT_SWIPE_UPDATE || out.type == EVENT_PINCH_UPDATE) {
+    out.dx = libinput_event_gesture_get_dx_unaccelerated(gev);
+    out.dy = libinput_event_gesture_get_dy_unaccelerated(gev);
+  }
+  if (gesture_of(out.type) == GESTURE_PINCH) {
+    out.scale = libinput_event_gesture_get_scale(gev);
+    out.angle = libinput_event_gesture_get_angle_delta(gev);
+  }
+  if (out.type == EVENT_SWIPE_END || out.type == EVENT_PINCH_END ||
+      out.type == EVENT_HOLD_END) {
+    out.cancelled = libinput_event_gesture_get_cancelled(gev);
+  }
+  return true;
+}
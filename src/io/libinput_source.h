@@ -0,0 +1,106 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_LIBINPUT_SOURCE_H
+#define GEBAAR_LIBINPUT_SOURCE_H
+
+#include <cerrno>
+#include <libinput.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <zconf.h>
+#include "event_source.h"
+
+#define TOUCH_RANGE             10000
+
+namespace gebaar::io {
+    class LibinputSource : public EventSource {
+    public:
+        LibinputSource() = default;
+
+        LibinputSource(bool use_path, std::vector<std::string> device_paths, bool keep_keyboards);
+
+        ~LibinputSource() override;
+
+        bool initialize() override;
+
+        int get_fd() const override;
+
+        size_t read_events(gebaar::gesture::gesture_event* events, size_t max) override;
+
+    private:
+        struct libinput* libinput = nullptr;
+        struct libinput_event* libinput_event = nullptr;
+        struct udev* udev = nullptr;
+        unsigned int modifier_keys = 0;
+        struct libinput_device* devices[GESTURE_MAX_DEVICES] = {};
+        device_info records[GESTURE_MAX_DEVICES];
+        bool use_path = false;
+        std::vector<std::string> device_paths;
+        bool keep_keyboards = true;
+
+        bool initialize_context();
+
+        bool initialize_path();
+
+        bool gesture_device_exists(std::vector<std::string>* device_nodes = nullptr);
+
+        static std::string find_cache_file();
+
+        static std::vector<std::string> read_device_cache();
+
+        static void write_device_cache(const std::vector<std::string>& device_nodes);
+
+        static int open_restricted(const char* path, int flags, void* user_data)
+        {
+            int fd = open(path, flags);
+            return fd < 0 ? -errno : fd;
+        }
+
+        static void close_restricted(int fd, void* user_data)
+        {
+            close(fd);
+        }
+
+        constexpr static struct libinput_interface libinput_interface = {
+                .open_restricted = open_restricted,
+                .close_restricted = close_restricted,
+        };
+
+        void add_device(struct libinput_device* device);
+
+        void remove_device(struct libinput_device* device);
+
+        static bool makes_gestures(struct libinput_device* device);
+
+        bool filter_device(struct libinput_device* device) const;
+
+        static unsigned int slot_of(struct libinput_device* device);
+
+        static device_info describe_device(struct libinput_device* device);
+
+        void track_modifiers(struct libinput_event* event);
+
+        unsigned int modifiers() const;
+
+        bool convert_event(struct libinput_event* event, gebaar::gesture::gesture_event& out) const;
+    };
+}
+
+#endif //GEBAAR_LIBINPUT_SOURCE_H
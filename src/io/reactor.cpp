@@ -0,0 +1,254 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cerrno>
+#include <filesystem>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "reactor.h"
+
+#define REACTOR_MAX_EVENTS      16
+
+gebaar::io::Reactor::Reactor()
+{
+    sigemptyset(&signal_mask);
+}
+
+gebaar::io::Reactor::~Reactor()
+{
+    for (int timer : timers) {
+        close(timer);
+    }
+    for (int fd : {signal_fd, inotify_fd, epoll_fd}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+/**
+ * Create the epoll instance
+ *
+ * @return bool
+ */
+bool gebaar::io::Reactor::initialize()
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return epoll_fd >= 0;
+}
+
+/**
+ * Call a handler whenever a file descriptor becomes readable. The handler
+ * gets the raw epoll events, so it can tell hangups and errors apart from
+ * data
+ *
+ * @param fd file descriptor to watch
+ * @param on_ready handler
+ * @return bool
+ */
+bool gebaar::io::Reactor::add(int fd, handler on_ready)
+{
+    struct epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return false;
+    }
+    handlers[fd] = std::move(on_ready);
+    return true;
+}
+
+/**
+ * Stop watching a file descriptor, the caller still owns it
+ *
+ * @param fd file descriptor
+ */
+void gebaar::io::Reactor::remove(int fd)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    handlers.erase(fd);
+}
+
+/**
+ * Also call the handler of a file descriptor when it becomes writable, for
+ * as long as there is output queued for it
+ *
+ * @param fd file descriptor added before
+ * @param writable whether to wait for EPOLLOUT
+ */
+void gebaar::io::Reactor::set_writable(int fd, bool writable)
+{
+    struct epoll_event event{};
+    event.events = writable ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+/**
+ * Block a signal and deliver it through the shared signalfd instead
+ *
+ * @param signo signal number
+ * @param on_signal called from the loop for every delivery
+ * @return bool
+ */
+bool gebaar::io::Reactor::watch_signal(int signo, callback on_signal)
+{
+    sigaddset(&signal_mask, signo);
+    if (sigprocmask(SIG_BLOCK, &signal_mask, nullptr) < 0) {
+        return false;
+    }
+    bool created = signal_fd < 0;
+    signal_fd = signalfd(signal_fd, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        return false;
+    }
+    signal_handlers[signo] = std::move(on_signal);
+    return !created || add(signal_fd, [this](uint32_t) { dispatch_signals(); });
+}
+
+/**
+ * Create a one-shot timer, disarmed until arm_timer is called
+ *
+ * @param on_expire called from the loop when the timer fires
+ * @return timer id or -1 on failure
+ */
+int gebaar::io::Reactor::add_timer(callback on_expire)
+{
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer < 0) {
+        return -1;
+    }
+    timers.push_back(timer);
+    bool added = add(timer, [timer, on_expire](uint32_t) {
+        uint64_t expirations;
+        if (read(timer, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            on_expire();
+        }
+    });
+    if (!added) {
+        timers.pop_back();
+        close(timer);
+        return -1;
+    }
+    return timer;
+}
+
+/**
+ * (Re)start a timer, replacing any pending expiry
+ *
+ * @param timer timer id from add_timer
+ * @param delay_usec delay until it fires, 0 disarms the timer
+ */
+void gebaar::io::Reactor::arm_timer(int timer, uint64_t delay_usec)
+{
+    struct itimerspec spec{};
+    spec.it_value.tv_sec = delay_usec / 1000000;
+    spec.it_value.tv_nsec = (delay_usec % 1000000) * 1000;
+    timerfd_settime(timer, 0, &spec, nullptr);
+}
+
+/**
+ * Get notified when a file is written or replaced. The parent directory is
+ * watched, since editors usually save by renaming a new file over the old
+ *
+ * @param path file to watch
+ * @param on_change called after the file changed
+ * @return bool
+ */
+bool gebaar::io::Reactor::watch_file(const std::string& path, callback on_change)
+{
+    if (inotify_fd < 0) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0 || !add(inotify_fd, [this](uint32_t) { dispatch_file_changes(); })) {
+            return false;
+        }
+    }
+    auto file = std::filesystem::path(path);
+    int wd = inotify_add_watch(inotify_fd, file.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        return false;
+    }
+    file_watches.push_back({wd, file.filename(), std::move(on_change)});
+    return true;
+}
+
+/**
+ * Dispatch events until stop() is called
+ */
+void gebaar::io::Reactor::run()
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    running = true;
+    while (running) {
+        int count = epoll_wait(epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "epoll_wait failed" << std::endl;
+            break;
+        }
+        ++wakeups;
+        for (int i = 0; i < count && running; ++i) {
+            auto found = handlers.find(events[i].data.fd);
+            // A handler may remove itself or others, run a copy
+            if (found != handlers.end()) {
+                handler on_ready = found->second;
+                on_ready(events[i].events);
+            }
+        }
+    }
+}
+
+/**
+ * Read every pending signal and run its callback
+ */
+void gebaar::io::Reactor::dispatch_signals()
+{
+    struct signalfd_siginfo info{};
+    while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        auto found = signal_handlers.find(info.ssi_signo);
+        if (found != signal_handlers.end()) {
+            found->second();
+        }
+    }
+}
+
+/**
+ * Read pending inotify events and run the callbacks of watched files
+ */
+void gebaar::io::Reactor::dispatch_file_changes()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            auto event = reinterpret_cast<struct inotify_event*>(ptr);
+            for (const auto& watch : file_watches) {
+                if (watch.wd == event->wd && event->len > 0 && watch.name == event->name) {
+                    watch.on_change();
+                }
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
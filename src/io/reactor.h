@@ -0,0 +1,92 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_REACTOR_H
+#define GEBAAR_REACTOR_H
+
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gebaar::io {
+    /**
+     * epoll based main loop. Besides plain file descriptors it multiplexes
+     * signals through one signalfd, timers through timerfds and file
+     * changes through one inotify instance, so nothing in the daemon ever
+     * has to block outside of epoll_wait.
+     */
+    class Reactor {
+    public:
+        using handler = std::function<void(uint32_t events)>;
+        using callback = std::function<void()>;
+
+        Reactor();
+
+        ~Reactor();
+
+        bool initialize();
+
+        bool add(int fd, handler on_ready);
+
+        void remove(int fd);
+
+        void set_writable(int fd, bool writable);
+
+        bool watch_signal(int signo, callback on_signal);
+
+        int add_timer(callback on_expire);
+
+        void arm_timer(int timer, uint64_t delay_usec);
+
+        bool watch_file(const std::string& path, callback on_change);
+
+        void run();
+
+        void stop() { running = false; }
+
+        uint64_t get_wakeups() const { return wakeups; }
+
+    private:
+        struct file_watch {
+            int wd;
+            std::string name;
+            callback on_change;
+        };
+
+        int epoll_fd = -1;
+        int signal_fd = -1;
+        int inotify_fd = -1;
+        bool running = false;
+        uint64_t wakeups = 0;
+        sigset_t signal_mask;
+
+        std::unordered_map<int, handler> handlers;
+        std::unordered_map<int, callback> signal_handlers;
+        std::vector<file_watch> file_watches;
+        std::vector<int> timers;
+
+        void dispatch_signals();
+
+        void dispatch_file_changes();
+    };
+}
+
+#endif //GEBAAR_REACTOR_H
@@ -0,0 +1,102 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "synthetic_source.h"
+
+/**
+ * Create the eventfd that signals queued events
+ *
+ * @return bool
+ */
+bool gebaar::io::SyntheticSource::initialize()
+{
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    update_fd();
+    return event_fd >= 0;
+}
+
+/**
+ * Hand out queued events in order
+ *
+ * @param events buffer to fill
+ * @param max size of the buffer
+ * @return number of events written
+ */
+size_t gebaar::io::SyntheticSource::read_events(gebaar::gesture::gesture_event* events, size_t max)
+{
+    size_t count = 0;
+    while (count < max && !queue.empty()) {
+        events[count++] = queue.front();
+        queue.pop_front();
+    }
+    update_fd();
+    return count;
+}
+
+/**
+ * Queue one event
+ *
+ * @param event event to queue
+ */
+void gebaar::io::SyntheticSource::push(const gebaar::gesture::gesture_event& event)
+{
+    queue.push_back(event);
+    update_fd();
+}
+
+/**
+ * Queue every event of a recorded trace
+ *
+ * @param reader opened trace
+ */
+void gebaar::io::SyntheticSource::load(const TraceReader& reader)
+{
+    for (const auto& record : reader) {
+        queue.push_back(from_record(record));
+    }
+    update_fd();
+}
+
+/**
+ * Keep the eventfd readable exactly while events are queued
+ */
+void gebaar::io::SyntheticSource::update_fd()
+{
+    if (event_fd < 0) {
+        return;
+    }
+    uint64_t value;
+    if (queue.empty()) {
+        while (read(event_fd, &value, sizeof(value)) > 0) {
+        }
+    } else {
+        value = 1;
+        if (write(event_fd, &value, sizeof(value)) < 0) {
+            // counter is saturated, the fd is readable either way
+        }
+    }
+}
+
+gebaar::io::SyntheticSource::~SyntheticSource()
+{
+    if (event_fd >= 0) {
+        close(event_fd);
+    }
+}
@@ -0,0 +1,55 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_SYNTHETIC_SOURCE_H
+#define GEBAAR_SYNTHETIC_SOURCE_H
+
+#include <deque>
+#include "event_source.h"
+#include "trace.h"
+
+namespace gebaar::io {
+    /**
+     * In-memory event source for replaying traces, benchmarks and fuzzing.
+     * Its fd is readable for as long as events are queued.
+     */
+    class SyntheticSource : public EventSource {
+    public:
+        ~SyntheticSource() override;
+
+        bool initialize() override;
+
+        int get_fd() const override { return event_fd; }
+
+        size_t read_events(gebaar::gesture::gesture_event* events, size_t max) override;
+
+        void push(const gebaar::gesture::gesture_event& event);
+
+        void load(const TraceReader& reader);
+
+        size_t pending() const { return queue.size(); }
+
+    private:
+        int event_fd = -1;
+        std::deque<gebaar::gesture::gesture_event> queue;
+
+        void update_fd();
+    };
+}
+
+#endif //GEBAAR_SYNTHETIC_SOURCE_H
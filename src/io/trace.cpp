@@ -0,0 +1,176 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace.h"
+
+/**
+ * Pack a gesture event into its on-disk form
+ *
+ * @param event gesture event
+ * @return trace record
+ */
+gebaar::io::trace_record gebaar::io::to_record(const gebaar::gesture::gesture_event& event)
+{
+    trace_record record{};
+    record.time_usec = event.time_usec;
+    record.type = event.type;
+    record.fingers = event.fingers;
+    record.cancelled = event.cancelled;
+    record.dx = event.dx;
+    record.dy = event.dy;
+    record.scale = event.scale;
+    record.angle = event.angle;
+    record.modifiers = event.modifiers;
+    record.device = event.device;
+    record.slot = event.slot;
+    if (gebaar::gesture::gesture_of(event.type) == gebaar::gesture::GESTURE_TOUCH) {
+        record.dx = event.x;
+        record.dy = event.y;
+    }
+    return record;
+}
+
+/**
+ * Unpack a trace record
+ *
+ * @param record trace record
+ * @return gesture event
+ */
+gebaar::gesture::gesture_event gebaar::io::from_record(const trace_record& record)
+{
+    gebaar::gesture::gesture_event event{};
+    event.type = static_cast<gebaar::gesture::event_type>(record.type);
+    event.fingers = record.fingers;
+    event.dx = record.dx;
+    event.dy = record.dy;
+    event.scale = record.scale;
+    event.angle = record.angle;
+    event.cancelled = record.cancelled != 0;
+    event.modifiers = record.modifiers;
+    event.device = record.device < GESTURE_MAX_DEVICES ? record.device : 0;
+    event.slot = record.slot;
+    if (gebaar::gesture::gesture_of(event.type) == gebaar::gesture::GESTURE_TOUCH) {
+        event.x = record.dx;
+        event.y = record.dy;
+        event.dx = 0;
+        event.dy = 0;
+    }
+    event.time_usec = record.time_usec;
+    return event;
+}
+
+/**
+ * Create a trace file and write its header
+ *
+ * @param path file to record to, truncated if it exists
+ * @return bool
+ */
+bool gebaar::io::TraceWriter::open(const std::string& path)
+{
+    file = fopen(path.c_str(), "wbe");
+    if (file == nullptr) {
+        std::cerr << "Failed to open trace file " << path << std::endl;
+        return false;
+    }
+    trace_header header{};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(trace_record);
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+/**
+ * Append an event, buffered until the next flush
+ *
+ * @param event event to append
+ */
+void gebaar::io::TraceWriter::write(const gebaar::gesture::gesture_event& event)
+{
+    if (file != nullptr) {
+        trace_record record = to_record(event);
+        fwrite(&record, sizeof(record), 1, file);
+    }
+}
+
+/**
+ * Push buffered records to the file
+ */
+void gebaar::io::TraceWriter::flush()
+{
+    if (file != nullptr) {
+        fflush(file);
+    }
+}
+
+gebaar::io::TraceWriter::~TraceWriter()
+{
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+/**
+ * Map a trace file and validate its header
+ *
+ * @param path trace file
+ * @return bool
+ */
+bool gebaar::io::TraceReader::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open trace file " << path << std::endl;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(trace_header))) {
+        std::cerr << path << " is not a gesture trace" << std::endl;
+        close(fd);
+        return false;
+    }
+    mapping_size = st.st_size;
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        return false;
+    }
+
+    auto header = static_cast<const trace_header*>(mapping);
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header->version != TRACE_VERSION
+        || header->record_size != sizeof(trace_record)) {
+        std::cerr << path << " is not a supported gesture trace" << std::endl;
+        return false;
+    }
+    records = reinterpret_cast<const trace_record*>(static_cast<const char*>(mapping) + sizeof(trace_header));
+    count = (mapping_size - sizeof(trace_header)) / sizeof(trace_record);
+    return true;
+}
+
+gebaar::io::TraceReader::~TraceReader()
+{
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+    }
+}
@@ -0,0 +1,98 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_TRACE_H
+#define GEBAAR_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "../gesture/event.h"
+
+#define TRACE_MAGIC             "GBTRACE"
+#define TRACE_VERSION           2
+
+namespace gebaar::io {
+    /*
+     * On-disk layout of a gesture trace, in host byte order: one header
+     * followed by fixed size records, so a trace can be mmap'ed and walked
+     * as an array.
+     */
+    struct trace_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+    };
+
+    struct trace_record {
+        uint64_t time_usec;
+        uint16_t type;          // gebaar::gesture::event_type
+        uint8_t fingers;
+        uint8_t cancelled;
+        float dx;               // unaccelerated, touch x for touch events
+        float dy;               // unaccelerated, touch y for touch events
+        float scale;
+        float angle;            // angle delta
+        uint8_t modifiers;
+        uint8_t device;
+        int8_t slot;            // touch slot
+        uint8_t reserved;
+    };
+
+    static_assert(sizeof(trace_header) == 16, "trace header layout changed");
+    static_assert(sizeof(trace_record) == 32, "trace record layout changed");
+
+    trace_record to_record(const gebaar::gesture::gesture_event& event);
+
+    gebaar::gesture::gesture_event from_record(const trace_record& record);
+
+    class TraceWriter {
+    public:
+        ~TraceWriter();
+
+        bool open(const std::string& path);
+
+        void write(const gebaar::gesture::gesture_event& event);
+
+        void flush();
+
+    private:
+        FILE* file = nullptr;
+    };
+
+    class TraceReader {
+    public:
+        ~TraceReader();
+
+        bool open(const std::string& path);
+
+        const trace_record* begin() const { return records; }
+
+        const trace_record* end() const { return records + count; }
+
+        size_t size() const { return count; }
+
+    private:
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        const trace_record* records = nullptr;
+        size_t count = 0;
+    };
+}
+
+#endif //GEBAAR_TRACE_H
@@ -0,0 +1,62 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include "../config/config.h"
+#include "bus.h"
+
+using namespace gebaar::gesture;
+
+gebaar::ipc::Bus::Bus(gebaar::io::Reactor& reactor)
+        :server(reactor)
+{
+}
+
+/**
+ * Start listening for subscribers
+ *
+ * @param path socket path
+ * @return bool
+ */
+bool gebaar::ipc::Bus::initialize(const std::string& path)
+{
+    return server.listen(path);
+}
+
+/**
+ * Tell every subscriber about a recognized gesture
+ *
+ * @param gesture recognized gesture
+ */
+void gebaar::ipc::Bus::publish(const recognized_gesture& gesture)
+{
+    if (!server.has_clients()) {
+        return;
+    }
+    const char* direction = gebaar::config::Config::direction_name(gesture.type, gesture.direction);
+
+    char message[BUS_MESSAGE_SIZE];
+    int size = snprintf(message, sizeof(message),
+                        "{\"gesture\":\"%s\",\"fingers\":%d,\"direction\":\"%s\",\"modifiers\":%u,\"device\":%u,"
+                        "\"time\":%llu}\n",
+                        gesture_name(gesture.type), gesture.fingers, direction != nullptr ? direction : "",
+                        gesture.modifiers, gesture.device, static_cast<unsigned long long>(gesture.time_usec));
+    if (size > 0 && size < static_cast<int>(sizeof(message))) {
+        server.broadcast(message, size);
+    }
+}
@@ -0,0 +1,48 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_BUS_H
+#define GEBAAR_BUS_H
+
+#include <string>
+#include "../gesture/event.h"
+#include "../io/reactor.h"
+#include "server.h"
+
+#define BUS_MESSAGE_SIZE        192
+
+namespace gebaar::ipc {
+    /**
+     * Broadcasts every recognized gesture as a JSON line, for local
+     * processes that want to react to gestures without being run as a
+     * command
+     */
+    class Bus {
+    public:
+        explicit Bus(gebaar::io::Reactor& reactor);
+
+        bool initialize(const std::string& path);
+
+        void publish(const gebaar::gesture::recognized_gesture& gesture);
+
+    private:
+        Server server;
+    };
+}
+
+#endif //GEBAAR_BUS_H
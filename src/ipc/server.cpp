@@ -0,0 +1,250 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+
+gebaar::ipc::Server::Server(gebaar::io::Reactor& reactor)
+        :reactor(reactor)
+{
+}
+
+gebaar::ipc::Server::~Server()
+{
+    for (auto& c : clients) {
+        reactor.remove(c.fd);
+        close(c.fd);
+    }
+    if (listen_fd >= 0) {
+        reactor.remove(listen_fd);
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+}
+
+/**
+ * Create the directory a socket lives in, readable by its owner only. A
+ * directory that exists already has to be one we made: not a symlink,
+ * owned by us and closed to everyone else, as /tmp is shared
+ *
+ * @param dir socket directory
+ * @return bool
+ */
+static bool private_directory(const std::filesystem::path& dir)
+{
+    std::error_code error;
+    std::filesystem::create_directories(dir.parent_path(), error);
+    if (mkdir(dir.c_str(), S_IRWXU) < 0 && errno != EEXIST) {
+        std::cerr << "Could not create " << dir.string() << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info{};
+    if (lstat(dir.c_str(), &info) < 0 || !S_ISDIR(info.st_mode) || info.st_uid != getuid()
+        || (info.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO)) != S_IRWXU) {
+        std::cerr << "Refusing " << dir.string() << ": not a directory owned by us with mode 0700" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Create the socket and start accepting clients, replacing a stale socket
+ * left behind by a previous run
+ *
+ * @param path socket path
+ * @return bool
+ */
+bool gebaar::ipc::Server::listen(const std::string& path)
+{
+    struct sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    if (!private_directory(std::filesystem::path(path).parent_path())) {
+        return false;
+    }
+    unlink(path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    bool bound = false;
+    if (listen_fd >= 0) {
+        // The socket is created with the umask, never open to others
+        mode_t mask = umask(S_IRWXG | S_IRWXO);
+        bound = bind(listen_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0;
+        umask(mask);
+    }
+    if (!bound || ::listen(listen_fd, SERVER_MAX_CLIENTS) < 0) {
+        std::cerr << "Could not listen on " << path << ": " << strerror(errno) << std::endl;
+    } else if (reactor.add(listen_fd, [this](uint32_t) { accept_clients(); })) {
+        socket_path = path;
+        return true;
+    }
+    if (bound) {
+        unlink(path.c_str());
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    return false;
+}
+
+/**
+ * Send a message to every client. Clients that cannot keep up are
+ * disconnected instead of ever making the caller wait
+ *
+ * @param data message
+ * @param size message length
+ */
+void gebaar::ipc::Server::broadcast(const char* data, size_t size)
+{
+    std::vector<int> slow;
+    for (auto& c : clients) {
+        if (c.size > 0) {
+            if (!queue(c, data, size)) {
+                slow.push_back(c.fd);
+            }
+            continue;
+        }
+        ssize_t sent = send(c.fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            slow.push_back(c.fd);
+        } else if (sent < static_cast<ssize_t>(size)) {
+            size_t done = sent < 0 ? 0 : sent;
+            queue(c, data + done, size - done);
+            reactor.set_writable(c.fd, true);
+        }
+    }
+    for (int fd : slow) {
+        disconnect(fd);
+    }
+}
+
+/**
+ * Accept every pending connection
+ */
+void gebaar::ipc::Server::accept_clients()
+{
+    int fd;
+    while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        if (clients.size() >= SERVER_MAX_CLIENTS
+            || !reactor.add(fd, [this, fd](uint32_t events) { handle_client(fd, events); })) {
+            close(fd);
+            continue;
+        }
+        clients.push_back({fd, std::make_unique<char[]>(SERVER_CLIENT_BUFFER)});
+    }
+}
+
+/**
+ * Client readiness. Clients have nothing to say, anything they send is
+ * discarded
+ *
+ * @param fd client socket
+ * @param events epoll events
+ */
+void gebaar::ipc::Server::handle_client(int fd, uint32_t events)
+{
+    auto found = std::find_if(clients.begin(), clients.end(), [fd](const client& c) { return c.fd == fd; });
+    if (found == clients.end()) {
+        return;
+    }
+    bool closed = events & (EPOLLHUP | EPOLLERR);
+    if (events & EPOLLIN) {
+        char discard[256];
+        ssize_t received;
+        while ((received = recv(fd, discard, sizeof(discard), MSG_DONTWAIT)) > 0) {
+        }
+        closed = closed || received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+    }
+    if (!closed && (events & EPOLLOUT)) {
+        closed = !flush(*found);
+    }
+    if (closed) {
+        disconnect(fd);
+    }
+}
+
+/**
+ * Append to the ring buffer of a client
+ *
+ * @param c client
+ * @param data bytes to queue
+ * @param size number of bytes
+ * @return false if they don't fit
+ */
+bool gebaar::ipc::Server::queue(client& c, const char* data, size_t size)
+{
+    if (size > SERVER_CLIENT_BUFFER - c.size) {
+        return false;
+    }
+    size_t tail = (c.head + c.size) % SERVER_CLIENT_BUFFER;
+    size_t first = std::min(size, SERVER_CLIENT_BUFFER - tail);
+    std::memcpy(c.buffer.get() + tail, data, first);
+    std::memcpy(c.buffer.get(), data + first, size - first);
+    c.size += size;
+    return true;
+}
+
+/**
+ * Write as much of the ring buffer of a client as it takes
+ *
+ * @param c client
+ * @return false if the client is gone
+ */
+bool gebaar::ipc::Server::flush(client& c)
+{
+    while (c.size > 0) {
+        size_t chunk = std::min(c.size, SERVER_CLIENT_BUFFER - c.head);
+        ssize_t sent = send(c.fd, c.buffer.get() + c.head, chunk, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        c.head = (c.head + sent) % SERVER_CLIENT_BUFFER;
+        c.size -= sent;
+    }
+    c.head = 0;
+    reactor.set_writable(c.fd, false);
+    return true;
+}
+
+/**
+ * Forget a client and close its socket
+ *
+ * @param fd client socket
+ */
+void gebaar::ipc::Server::disconnect(int fd)
+{
+    reactor.remove(fd);
+    close(fd);
+    clients.erase(std::remove_if(clients.begin(), clients.end(), [fd](const client& c) { return c.fd == fd; }),
+                  clients.end());
+}
@@ -0,0 +1,75 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_SERVER_H
+#define GEBAAR_SERVER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../io/reactor.h"
+
+#define SERVER_MAX_CLIENTS      16
+#define SERVER_CLIENT_BUFFER    65536
+
+namespace gebaar::ipc {
+    /**
+     * Unix domain socket that broadcasts messages to every connected client.
+     * Writes never block the loop: whatever a client does not take right
+     * away is queued in its ring buffer, and a client that lets its buffer
+     * fill up is disconnected.
+     */
+    class Server {
+    public:
+        explicit Server(gebaar::io::Reactor& reactor);
+
+        ~Server();
+
+        bool listen(const std::string& path);
+
+        bool has_clients() const { return !clients.empty(); }
+
+        void broadcast(const char* data, size_t size);
+
+    private:
+        struct client {
+            int fd;
+            std::unique_ptr<char[]> buffer;
+            size_t head = 0;    // first queued byte
+            size_t size = 0;    // queued bytes
+        };
+
+        gebaar::io::Reactor& reactor;
+        std::string socket_path;
+        int listen_fd = -1;
+        std::vector<client> clients;
+
+        void accept_clients();
+
+        void handle_client(int fd, uint32_t events);
+
+        bool queue(client& c, const char* data, size_t size);
+
+        bool flush(client& c);
+
+        void disconnect(int fd);
+    };
+}
+
+#endif //GEBAAR_SERVER_H
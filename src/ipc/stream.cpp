@@ -0,0 +1,113 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include "../stats/histogram.h"
+#include "stream.h"
+
+using namespace gebaar::gesture;
+
+gebaar::ipc::Stream::Stream(gebaar::io::Reactor& reactor)
+        :reactor(reactor), server(reactor)
+{
+}
+
+/**
+ * Start listening for subscribers
+ *
+ * @param path socket path
+ * @param rate maximum updates per second and device
+ * @return bool
+ */
+bool gebaar::ipc::Stream::initialize(const std::string& path, unsigned int rate)
+{
+    interval_usec = rate > 0 ? 1000000 / rate : 0;
+    timer = reactor.add_timer([this] {
+        timer_armed = false;
+        flush_pending();
+    });
+    return timer >= 0 && server.listen(path);
+}
+
+/**
+ * Hand the progress of a gesture to the subscribers
+ *
+ * @param progress gesture progress
+ */
+void gebaar::ipc::Stream::publish(const gesture_progress& progress)
+{
+    if (!server.has_clients()) {
+        pending_devices = 0;
+        return;
+    }
+    uint32_t bit = 1u << progress.device;
+    if (progress.phase != PROGRESS_UPDATE) {
+        // Keep the order: the last update of a gesture goes before its end
+        if (pending_devices & bit) {
+            pending_devices &= ~bit;
+            send(pending[progress.device]);
+        }
+        send(progress);
+        return;
+    }
+
+    pending[progress.device] = progress;
+    pending_devices |= bit;
+    uint64_t since_flush = gebaar::stats::now_usec() - last_flush_usec;
+    if (since_flush >= interval_usec) {
+        flush_pending();
+    } else if (!timer_armed) {
+        reactor.arm_timer(timer, interval_usec - since_flush);
+        timer_armed = true;
+    }
+}
+
+/**
+ * Send the latest update of every device that has one waiting
+ */
+void gebaar::ipc::Stream::flush_pending()
+{
+    for (unsigned int device = 0; pending_devices != 0; ++device) {
+        if (pending_devices & (1u << device)) {
+            pending_devices &= ~(1u << device);
+            send(pending[device]);
+        }
+    }
+    last_flush_usec = gebaar::stats::now_usec();
+}
+
+/**
+ * Format one progress message, without touching the heap
+ *
+ * @param progress gesture progress
+ */
+void gebaar::ipc::Stream::send(const gesture_progress& progress)
+{
+    static const char* const phases[] = {"begin", "update", "end"};
+
+    char message[STREAM_MESSAGE_SIZE];
+    int size = snprintf(message, sizeof(message),
+                        "{\"phase\":\"%s\",\"gesture\":\"%s\",\"fingers\":%d,\"device\":%u,\"progress\":%.4f,"
+                        "\"dx\":%.2f,\"dy\":%.2f,\"scale\":%.4f,\"angle\":%.2f,\"cancelled\":%s,\"time\":%llu}\n",
+                        phases[progress.phase], gesture_name(progress.type), progress.fingers, progress.device,
+                        progress.progress, progress.dx, progress.dy, progress.scale, progress.angle,
+                        progress.cancelled ? "true" : "false", static_cast<unsigned long long>(progress.time_usec));
+    if (size > 0 && size < static_cast<int>(sizeof(message))) {
+        server.broadcast(message, size);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_STREAM_H
+#define GEBAAR_STREAM_H
+
+#include <cstdint>
+#include <string>
+#include "../gesture/event.h"
+#include "../io/reactor.h"
+#include "server.h"
+
+#define STREAM_MESSAGE_SIZE     256
+
+namespace gebaar::ipc {
+    /**
+     * Streams the progress of gestures to subscribers as JSON lines, so they
+     * can animate along with a gesture instead of reacting to its steps.
+     * Begin and end are sent right away, updates are coalesced per device to
+     * at most one per frame of the configured rate.
+     */
+    class Stream {
+    public:
+        explicit Stream(gebaar::io::Reactor& reactor);
+
+        bool initialize(const std::string& path, unsigned int rate);
+
+        void publish(const gebaar::gesture::gesture_progress& progress);
+
+    private:
+        gebaar::io::Reactor& reactor;
+        Server server;
+        int timer = -1;
+        bool timer_armed = false;
+        uint64_t interval_usec = 0;
+        uint64_t last_flush_usec = 0;
+
+        gebaar::gesture::gesture_progress pending[GESTURE_MAX_DEVICES];
+        uint32_t pending_devices = 0;
+
+        void flush_pending();
+
+        void send(const gebaar::gesture::gesture_progress& progress);
+    };
+}
+
+#endif //GEBAAR_STREAM_H
@@ -21,6 +21,8 @@
 #include <cxxopts.hpp>
 #include "config/config.h"
 #include "io/input.h"
+#include "io/libinput_source.h"
+#include "stats/startup.h"
 #include "daemonizer.h"
 
 gebaar::io::Input* input;
@@ -30,9 +32,13 @@ int main(int argc, char* argv[])
     cxxopts::Options options(argv[0], "Gebaard Gestures Daemon");
 
     bool should_daemonize = false;
+    bool print_stats = false;
+    std::string record_path;
 
     options.add_options()
             ("b,background", "Daemonize", cxxopts::value(should_daemonize))
+            ("s,stats", "Print latency statistics on exit", cxxopts::value(print_stats))
+            ("r,record", "Record gesture events to a trace file", cxxopts::value(record_path))
             ("h,help", "Prints this help text");
 
     auto result = options.parse(argc, argv);
@@ -42,16 +48,32 @@ int main(int argc, char* argv[])
         exit(EXIT_SUCCESS);
     }
 
+    // The daemon changes its working directory, resolve relative paths first
+    if (!record_path.empty()) {
+        record_path = std::filesystem::absolute(record_path);
+    }
+
     if (should_daemonize) {
         auto *daemonizer = new gebaar::daemonizer::Daemonizer();
         daemonizer->daemonize();
+        gebaar::stats::startup.mark("daemonize");
+    }
+    std::shared_ptr<const gebaar::config::Config> config = std::make_shared<gebaar::config::Config>();
+    gebaar::stats::startup.mark("config");
+    input = new gebaar::io::Input(config,
+                                  std::make_unique<gebaar::io::LibinputSource>(config->settings.input_backend == "path",
+                                                                               config->settings.input_devices,
+                                                                               config->bindings.uses_modifiers()),
+                                  print_stats);
+
+    if (!record_path.empty() && !input->start_recording(record_path)) {
+        exit(EXIT_FAILURE);
     }
-    std::shared_ptr<gebaar::config::Config> config = std::make_shared<gebaar::config::Config>();
-    input = new gebaar::io::Input(config);
 
     if (input->initialize()) {
         input->start_loop();
     }
+    delete input;
 
     return 0;
 }
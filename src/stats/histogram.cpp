@@ -0,0 +1,126 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ctime>
+#include <iomanip>
+#include "histogram.h"
+
+/**
+ * Add a value to the histogram
+ *
+ * @param value value to record, usually microseconds
+ */
+void gebaar::stats::Histogram::record(uint64_t value)
+{
+    ++buckets[bucket_index(value)];
+    ++count;
+    if (value < min) {
+        min = value;
+    }
+    if (value > max) {
+        max = value;
+    }
+}
+
+/**
+ * Value below which the given share of recorded values falls
+ *
+ * @param p percentile between 0 and 100
+ * @return upper bound of the bucket holding the percentile
+ */
+uint64_t gebaar::stats::Histogram::percentile(double p) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    auto wanted = static_cast<uint64_t>(p / 100.0 * count + 0.5);
+    if (wanted == 0) {
+        wanted = 1;
+    }
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < sizeof(buckets) / sizeof(buckets[0]); ++i) {
+        seen += buckets[i];
+        if (seen >= wanted) {
+            uint64_t value = bucket_value(i);
+            return value > max ? max : value;
+        }
+    }
+    return max;
+}
+
+/**
+ * Write count, min, common percentiles and max on one line
+ *
+ * @param out stream to print to
+ */
+void gebaar::stats::Histogram::print(std::ostream& out) const
+{
+    out << std::setw(8) << count
+        << std::setw(10) << (count ? min : 0)
+        << std::setw(10) << percentile(50)
+        << std::setw(10) << percentile(90)
+        << std::setw(10) << percentile(99)
+        << std::setw(10) << max;
+}
+
+/**
+ * Map a value to its bucket, the first 16 values get a bucket each and every
+ * following power of two is split into 16 buckets
+ *
+ * @param value value to place
+ * @return bucket index
+ */
+unsigned int gebaar::stats::Histogram::bucket_index(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return static_cast<unsigned int>(value);
+    }
+    unsigned int shift = 63 - __builtin_clzll(value) - 4;
+    unsigned int index = (shift + 1) * HISTOGRAM_SUB_BUCKETS
+                         + static_cast<unsigned int>((value >> shift) - HISTOGRAM_SUB_BUCKETS);
+    unsigned int last = HISTOGRAM_SUB_BUCKETS * HISTOGRAM_MAGNITUDES - 1;
+    return index > last ? last : index;
+}
+
+/**
+ * Highest value that falls into a bucket
+ *
+ * @param index bucket index
+ * @return bucket upper bound
+ */
+uint64_t gebaar::stats::Histogram::bucket_value(unsigned int index)
+{
+    unsigned int magnitude = index / HISTOGRAM_SUB_BUCKETS;
+    unsigned int sub = index % HISTOGRAM_SUB_BUCKETS;
+    if (magnitude == 0) {
+        return sub;
+    }
+    return ((static_cast<uint64_t>(HISTOGRAM_SUB_BUCKETS + sub + 1)) << (magnitude - 1)) - 1;
+}
+
+/**
+ * Current CLOCK_MONOTONIC time, the clock libinput timestamps events with
+ *
+ * @return microseconds
+ */
+uint64_t gebaar::stats::now_usec()
+{
+    struct timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
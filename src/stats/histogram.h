@@ -0,0 +1,58 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_HISTOGRAM_H
+#define GEBAAR_HISTOGRAM_H
+
+#include <cstdint>
+#include <ostream>
+
+#define HISTOGRAM_SUB_BUCKETS   16
+#define HISTOGRAM_MAGNITUDES    40
+
+namespace gebaar::stats {
+    /**
+     * Fixed size log-linear histogram in the spirit of HdrHistogram. Every
+     * power of two is split into 16 linear buckets, which keeps the relative
+     * error of reported values under 6.25% without any allocation.
+     */
+    class Histogram {
+    public:
+        void record(uint64_t value);
+
+        uint64_t get_count() const { return count; }
+
+        uint64_t percentile(double p) const;
+
+        void print(std::ostream& out) const;
+
+    private:
+        uint32_t buckets[HISTOGRAM_SUB_BUCKETS * HISTOGRAM_MAGNITUDES] = {};
+        uint64_t count = 0;
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+
+        static unsigned int bucket_index(uint64_t value);
+
+        static uint64_t bucket_value(unsigned int index);
+    };
+
+    uint64_t now_usec();
+}
+
+#endif //GEBAAR_HISTOGRAM_H
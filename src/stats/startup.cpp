@@ -0,0 +1,47 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "startup.h"
+
+gebaar::stats::StartupTimer gebaar::stats::startup;
+
+/**
+ * End the current phase
+ *
+ * @param phase name of the phase that just finished
+ */
+void gebaar::stats::StartupTimer::mark(const char* phase)
+{
+    uint64_t now = now_usec();
+    phases.emplace_back(phase, now - last_usec);
+    last_usec = now;
+}
+
+/**
+ * Print every phase and the total on one line, all values in microseconds
+ *
+ * @param out stream to print to
+ */
+void gebaar::stats::StartupTimer::print(std::ostream& out) const
+{
+    out << "startup (usec)";
+    for (const auto& phase : phases) {
+        out << "  " << phase.first << " " << phase.second;
+    }
+    out << "  total " << last_usec - start_usec;
+}
@@ -0,0 +1,49 @@
+/*
+    gebaar
+    Copyright (C) 2019   coffee2code
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GEBAAR_STARTUP_H
+#define GEBAAR_STARTUP_H
+
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "histogram.h"
+
+namespace gebaar::stats {
+    /**
+     * Breakdown of how long the daemon took to become ready. Every mark
+     * closes a phase that began at the previous mark, the first phase begins
+     * when the process started
+     */
+    class StartupTimer {
+    public:
+        void mark(const char* phase);
+
+        void print(std::ostream& out) const;
+
+    private:
+        uint64_t start_usec = now_usec();
+        uint64_t last_usec = start_usec;
+        std::vector<std::pair<const char*, uint64_t>> phases;
+    };
+
+    extern StartupTimer startup;
+}
+
+#endif //GEBAAR_STARTUP_H
@@ -16,6 +16,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdlib>
+#include <unistd.h>
 #include "util.h"
 
 /**
@@ -27,3 +29,19 @@ std::string gebaar::util::stringFromCharArray(char* charArr)
 {
     return charArr == nullptr ? "" : charArr;
 }
+
+/**
+ * @brief Path of a file in the per user runtime directory, for sockets
+ * @param name file name
+ * @return $XDG_RUNTIME_DIR/gebaar/name, or a per user directory in /tmp
+ */
+std::string gebaar::util::runtimePath(const std::string& name)
+{
+    std::string dir = stringFromCharArray(getenv("XDG_RUNTIME_DIR"));
+    if (dir.empty()) {
+        dir = "/tmp/gebaar-" + std::to_string(getuid());
+    } else {
+        dir.append("/gebaar");
+    }
+    return dir + "/" + name;
+}
@@ -23,6 +23,8 @@
 
 namespace gebaar::util {
     std::string stringFromCharArray(char* charArr);
+
+    std::string runtimePath(const std::string& name);
 }
 
 #endif // UTIL_H